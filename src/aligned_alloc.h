@@ -9,7 +9,10 @@ static
 void* aligned_alloc_posix(size_t alignment, size_t size)
 {
 	void* ptr = nullptr;
-	assert(posix_memalign(&ptr, alignment, size) == 0 && ptr != nullptr);
+	// 不能把posix_memalign放在assert里：-DNDEBUG时它不会被调用；
+	if (posix_memalign(&ptr, alignment, size) != 0 || ptr == nullptr) {
+		abort();
+	}
 	return ptr;
 }
 
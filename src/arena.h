@@ -0,0 +1,134 @@
+// A thread-caching bump arena for `Layout` blocks.
+//
+//   Arena arena;
+//   const MyCompactFoo::L layout(1, 1, num_floats, num_doubles);
+//   unsigned char* p = arena.Allocate(layout);  // AllocSize() bytes aligned
+//                                               // to Alignment()
+//
+// Memory is carved out of large chunks. Every thread bumps a pointer in its
+// own chunk, so allocation takes no lock and touches no shared cache line in
+// the common case; the arena's mutex is taken only to get a new chunk.
+// Individual blocks are never freed: everything is released when the arena
+// is destroyed. Blocks larger than a quarter of a chunk get a chunk of their
+// own.
+//
+// Each thread caches a chunk of one arena at a time. A thread that alternates
+// between several arenas still works, but starts a new chunk on every switch.
+
+#ifndef ABSL_CONTAINER_INTERNAL_ARENA_H_
+#define ABSL_CONTAINER_INTERNAL_ARENA_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+class Arena {
+ public:
+  static constexpr size_t kDefaultChunkSize = size_t{1} << 20;
+
+  explicit Arena(size_t chunk_size = kDefaultChunkSize)
+      : id_(NextId()), chunk_size_(chunk_size) {}
+
+  ~Arena() {
+    for (const Chunk& c : chunks_) {
+      ::operator delete(c.p, std::align_val_t{c.alignment});
+    }
+  }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Allocates `size` bytes aligned to `alignment`. Thread-safe.
+  //
+  // Requires: `alignment` is a power of 2.
+  unsigned char* Allocate(size_t size, size_t alignment) {
+    using internal_layout::adl_barrier::Align;
+    assert(internal_layout::adl_barrier::IsPow2(alignment));
+    Cache& c = LocalCache();
+    if (c.id == id_) {
+      uintptr_t p = Align(reinterpret_cast<uintptr_t>(c.cur), alignment);
+      if (p + size <= reinterpret_cast<uintptr_t>(c.end)) {
+        c.cur = reinterpret_cast<unsigned char*>(p + size);
+        return reinterpret_cast<unsigned char*>(p);
+      }
+    }
+    if (size + alignment > chunk_size_ / 4) {
+      return NewChunk(size, alignment);
+    }
+    // Start a new chunk; the retry is guaranteed to fit.
+    c.cur = NewChunk(chunk_size_, internal_layout::kCacheLineSize);
+    c.end = c.cur + chunk_size_;
+    c.id = id_;
+    return Allocate(size, alignment);
+  }
+
+  // Allocates a block for `layout`: `AllocSize()` bytes aligned to
+  // `Alignment()`.
+  template <class L>
+  unsigned char* Allocate(const L& layout) {
+    return Allocate(layout.AllocSize(), L::Alignment());
+  }
+
+  // Bytes obtained from the system so far.
+  size_t bytes_reserved() const {
+    return reserved_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Cache {
+    uint64_t id = 0;
+    unsigned char* cur = nullptr;
+    unsigned char* end = nullptr;
+  };
+
+  // Freed with the alignment it was allocated with.
+  struct Chunk {
+    void* p;
+    size_t alignment;
+  };
+
+  static Cache& LocalCache() {
+    thread_local Cache cache;
+    return cache;
+  }
+
+  // Arena ids are never reused, so a cache left behind by a destroyed arena
+  // can't be mistaken for a live one.
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  unsigned char* NewChunk(size_t size, size_t alignment) {
+    if (alignment < internal_layout::kCacheLineSize) {
+      alignment = internal_layout::kCacheLineSize;
+    }
+    size = internal_layout::adl_barrier::Align(size, alignment);
+    void* p = ::operator new(size, std::align_val_t{alignment});
+    reserved_.fetch_add(size, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mu_);
+    chunks_.push_back(Chunk{p, alignment});
+    return static_cast<unsigned char*>(p);
+  }
+
+  const uint64_t id_;
+  const size_t chunk_size_;
+  std::atomic<size_t> reserved_{0};
+  std::mutex mu_;
+  std::vector<Chunk> chunks_;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_ARENA_H_
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "btree_map.h"
+
+using namespace absl::container_internal;
+
+// 有序map：BTreeMap（512字节的Layout节点，key数组上做SIMD计数）对比std::map
+// （每个元素一个节点，每层一次cache miss）。随机查找，以及区间扫描。
+//
+// 用法：./bench_btree [elements] [lookups]
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+void Print(const char* name, double insert_ns, double find_ns, double scan_ns,
+           uint64_t check) {
+  std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+            << std::setprecision(1) << "insert " << std::setw(6) << insert_ns
+            << " ns, find " << std::setw(6) << find_ns << " ns, scan "
+            << std::setw(5) << scan_ns << " ns/elem  (" << check << ")"
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+  const size_t lookups = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000000;
+
+  std::mt19937_64 rng(1);
+  std::vector<int64_t> keys(n), probes(lookups);
+  for (auto& k : keys) k = rng() >> 2;
+  for (auto& k : probes) k = keys[rng() % n];
+
+  {
+    BTreeMap<int64_t, int64_t> m;
+    auto begin = std::chrono::steady_clock::now();
+    for (int64_t k : keys) m.insert(k, k);
+    const double insert_ns = Seconds(begin) * 1e9 / n;
+    uint64_t sum = 0;
+    begin = std::chrono::steady_clock::now();
+    for (int64_t k : probes) sum += m.find(k).value();
+    const double find_ns = Seconds(begin) * 1e9 / lookups;
+    begin = std::chrono::steady_clock::now();
+    m.Scan(INT64_MIN, INT64_MAX, [&](int64_t, int64_t& v) { sum += v; });
+    const double scan_ns = Seconds(begin) * 1e9 / m.size();
+    Print("BTreeMap", insert_ns, find_ns, scan_ns, sum);
+    std::cout << "  " << m.node_count() << " nodes of 512 bytes, height "
+              << m.height() << std::endl;
+  }
+  {
+    std::map<int64_t, int64_t> m;
+    auto begin = std::chrono::steady_clock::now();
+    for (int64_t k : keys) m.emplace(k, k);
+    const double insert_ns = Seconds(begin) * 1e9 / n;
+    uint64_t sum = 0;
+    begin = std::chrono::steady_clock::now();
+    for (int64_t k : probes) sum += m.find(k)->second;
+    const double find_ns = Seconds(begin) * 1e9 / lookups;
+    begin = std::chrono::steady_clock::now();
+    for (auto& [k, v] : m) sum += v;
+    const double scan_ns = Seconds(begin) * 1e9 / m.size();
+    Print("std::map", insert_ns, find_ns, scan_ns, sum);
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "parallel_builder.h"
+#include "thread_pool.h"
+
+using namespace absl::container_internal;
+
+// 构造一个很大的MyCompactFoo：对比test_serialize.cpp中create()的单线程memcpy，
+// 与ParallelBuilder在1, 2, 4, ...个线程上的带宽。
+//
+// 用法：./bench_builder [MB] [max-threads]
+
+namespace {
+
+using L = Layout<size_t, size_t, float, double>;
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t mb = argc > 1 ? strtoull(argv[1], nullptr, 10) : 256;
+  const size_t max_threads =
+      argc > 2 ? strtoull(argv[2], nullptr, 10)
+               : std::max<size_t>(1, std::thread::hardware_concurrency());
+
+  // 一半字节给floats，一半给doubles；
+  const size_t nf = mb * (1 << 20) / 2 / sizeof(float);
+  const size_t nd = mb * (1 << 20) / 2 / sizeof(double);
+  std::vector<float> floats(nf, 1.0f);
+  std::vector<double> doubles(nd, 2.0);
+  const L layout(1, 1, nf, nd);
+  std::cout << "block: " << layout.AllocSize() / (1 << 20) << " MB" << std::endl;
+
+  {
+    // 基线：和create()一样，单线程memcpy到malloc出来（未touch）的内存；
+    auto begin = std::chrono::steady_clock::now();
+    unsigned char* p =
+        (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+    *layout.Pointer<0>(p) = nf;
+    *layout.Pointer<1>(p) = nd;
+    memcpy(layout.Pointer<2>(p), floats.data(), nf * sizeof(float));
+    memcpy(layout.Pointer<3>(p), doubles.data(), nd * sizeof(double));
+    double secs = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count();
+    std::cout << std::setw(10) << "memcpy" << std::setw(10) << std::fixed
+              << std::setprecision(2) << layout.AllocSize() / secs / 1e9
+              << " GB/s" << std::endl;
+    free(p);
+  }
+
+  for (size_t t = 1; t <= max_threads; t *= 2) {
+    ThreadPool pool(t, /*pin=*/true);
+    ParallelBuilder<L> builder(pool, layout);
+    builder.Transform<0>([&](size_t) { return nf; });
+    builder.Transform<1>([&](size_t) { return nd; });
+    builder.Copy<2>(floats.data());
+    builder.Copy<3>(doubles.data());
+    std::cout << std::setw(6) << t << " thr" << std::setw(10) << std::fixed
+              << std::setprecision(2) << builder.stats().GBps() << " GB/s"
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "column_codec.h"
+
+using namespace absl::container_internal;
+
+// 压缩比与解码速度：解码输出的GB/s（按原始字节算）要远高于SSD的读带宽，
+// 否则不如直接读原始字节。对比memcpy作为上限。
+//
+// 用法：./bench_codec [rows] [iterations]
+
+namespace {
+
+using L = Layout<Field<"id", uint64_t>, Field<"level", int32_t>,
+                 Field<"state", uint8_t>, Field<"price", double>,
+                 Field<"ts", int64_t>>;
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+  const size_t iters = argc > 2 ? strtoull(argv[2], nullptr, 10) : 5;
+
+  const L layout(n, n, n, n, n);
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+  unsigned char* q = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+  srand(1);
+  for (size_t i = 0; i < n; ++i) {
+    layout.Pointer<"id">(p)[i] = 5000000 + rand() % 100000;
+    layout.Pointer<"level">(p)[i] = rand() % 100;
+    layout.Pointer<"state">(p)[i] = (i >> 12) & 3;
+    layout.Pointer<"price">(p)[i] = 100.0 + (i / 64) * 0.25;
+    layout.Pointer<"ts">(p)[i] = 1700000000000 + i * 10 + rand() % 10;
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<unsigned char> enc = EncodeColumns(layout, p);
+  const double encode_secs = Seconds(begin);
+  EncodedColumns cols(enc.data(), enc.size());
+
+  std::cout << "raw " << layout.AllocSize() << " bytes, encoded " << enc.size()
+            << " bytes, ratio " << std::fixed << std::setprecision(2)
+            << double(layout.AllocSize()) / enc.size() << ", encode "
+            << layout.AllocSize() / encode_secs / 1e9 << " GB/s" << std::endl;
+  for (size_t i = 0; i < cols.num_columns(); ++i) {
+    std::cout << std::setw(8) << CodecName(cols.codec(i)) << std::setw(12)
+              << cols.encoded_bytes(i) << std::endl;
+  }
+
+  double memcpy_secs = 1e9, decode_secs = 1e9;
+  for (size_t it = 0; it < iters; ++it) {
+    begin = std::chrono::steady_clock::now();
+    memcpy(q, p, layout.AllocSize());
+    memcpy_secs = std::min(memcpy_secs, Seconds(begin));
+
+    begin = std::chrono::steady_clock::now();
+    if (!cols.DecodeAll(layout, q)) return 1;
+    decode_secs = std::min(decode_secs, Seconds(begin));
+  }
+  std::cout << std::setw(8) << "memcpy" << std::setw(10)
+            << layout.AllocSize() / memcpy_secs / 1e9 << " GB/s" << std::endl;
+  std::cout << std::setw(8) << "decode" << std::setw(10)
+            << layout.AllocSize() / decode_secs / 1e9 << " GB/s" << std::endl;
+
+  free(q);
+  free(p);
+  return 0;
+}
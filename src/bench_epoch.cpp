@@ -0,0 +1,153 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "epoch.h"
+#include "layout.h"
+
+using namespace absl::container_internal;
+
+// 读多写少的路由表：读者线程数从1到max-threads，每个读者反复“进入临界区，
+// 取当前表，读一个条目”；同时一个写者每隔100us发布一张新表。
+//
+// 对比：
+//   - raw     ：只做一次acquire load，不保护（不安全，作为下限）；
+//   - epoch   ：EpochDomain::Read() + EpochPtr::load()；
+//   - mutex   ：在std::mutex下复制std::shared_ptr；
+//
+// 用法：./bench_epoch [reads-per-thread] [max-threads]
+
+namespace {
+
+using L = Layout<size_t, uint64_t>;
+constexpr size_t kEntries = 1024;
+
+// 本线程的CPU时间：线程数超过核数时，墙上时间会包含其它线程运行的时间；
+double ThreadSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+unsigned char* NewTable(uint64_t version) {
+  const L layout(1, kEntries);
+  unsigned char* p = static_cast<unsigned char*>(
+      ::operator new(layout.AllocSize(), std::align_val_t{L::Alignment()}));
+  *layout.Pointer<0>(p) = kEntries;
+  for (size_t i = 0; i < kEntries; ++i) layout.Pointer<1>(p)[i] = version;
+  return p;
+}
+
+void FreeTable(unsigned char* p) {
+  ::operator delete(p, std::align_val_t{L::Alignment()});
+}
+
+uint64_t ReadEntry(const unsigned char* p, size_t i) {
+  return L::Partial(1, kEntries).Pointer<1>(p)[i % kEntries];
+}
+
+// `threads`个读者各执行`read(i)` `reads`次，同时`publish()`每100us执行一次；
+// 返回每次读取的平均耗时（ns，读者线程的CPU时间）；
+template <class Read, class Publish>
+double Run(size_t threads, size_t reads, Read read, Publish publish) {
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    while (!stop.load(std::memory_order_relaxed)) {
+      publish();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+  std::vector<double> secs(threads);
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < threads; ++t) {
+    readers.emplace_back([&, t] {
+      const double begin = ThreadSeconds();
+      uint64_t sum = 0;
+      for (size_t i = 0; i < reads; ++i) sum += read(i);
+      secs[t] = ThreadSeconds() - begin;
+      if (sum == 42) std::cout << "";
+    });
+  }
+  for (auto& th : readers) th.join();
+  stop = true;
+  writer.join();
+  double total = 0;
+  for (double s : secs) total += s;
+  return total / threads * 1e9 / reads;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t reads = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+  const size_t max_threads = argc > 2 ? strtoull(argv[2], nullptr, 10) : 64;
+
+  std::cout << "membarrier: "
+            << (EpochDomain().uses_membarrier() ? "yes" : "no (fences)")
+            << std::endl;
+  for (size_t threads = 1; threads <= max_threads; threads *= 4) {
+    uint64_t version = 0;
+    double raw_ns, epoch_ns, mutex_ns;
+    {
+      // 不回收：旧表留到最后统一释放；
+      std::atomic<unsigned char*> table{NewTable(0)};
+      std::vector<unsigned char*> old;
+      raw_ns = Run(
+          threads, reads,
+          [&](size_t i) {
+            return ReadEntry(table.load(std::memory_order_acquire), i);
+          },
+          [&] { old.push_back(table.exchange(NewTable(++version))); });
+      for (unsigned char* p : old) FreeTable(p);
+      FreeTable(table.load());
+    }
+    {
+      EpochDomain domain;
+      EpochPtr<unsigned char> table(NewTable(0));
+      epoch_ns = Run(
+          threads, reads,
+          [&](size_t i) {
+            auto guard = domain.Read();
+            return ReadEntry(table.load(), i);
+          },
+          [&] { table.Publish(domain, NewTable(++version), FreeTable); });
+      domain.Synchronize();
+      FreeTable(table.load());
+    }
+    {
+      std::mutex mu;
+      std::shared_ptr<unsigned char> table(NewTable(0), FreeTable);
+      mutex_ns = Run(
+          threads, reads,
+          [&](size_t i) {
+            std::shared_ptr<unsigned char> p;
+            {
+              std::lock_guard<std::mutex> lock(mu);
+              p = table;
+            }
+            return ReadEntry(p.get(), i);
+          },
+          [&] {
+            std::shared_ptr<unsigned char> p(NewTable(++version), FreeTable);
+            std::lock_guard<std::mutex> lock(mu);
+            table.swap(p);
+          });
+    }
+    std::cout << std::setw(2) << threads << " readers: " << std::fixed
+              << std::setprecision(2) << "raw " << std::setw(6) << raw_ns
+              << " ns, epoch " << std::setw(6) << epoch_ns << " ns, mutex "
+              << std::setw(6) << mutex_ns << " ns  per read" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "flat_hash_map.h"
+
+using namespace absl::container_internal;
+
+// 查找为主的负载：FlatHashMap（一个Layout块，按group做SIMD探测）
+// 对比基于节点的std::unordered_map。查找的key是随机顺序，
+// 表远大于cache时，差别主要在每次查找的cache miss数。
+//
+// 用法：./bench_hash [elements] [lookups]
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+template <class Map>
+void Run(const char* name, const std::vector<uint64_t>& keys,
+         const std::vector<uint64_t>& hits, const std::vector<uint64_t>& misses) {
+  Map m;
+  auto begin = std::chrono::steady_clock::now();
+  for (uint64_t k : keys) m[k] = k;
+  const double insert_ns = Seconds(begin) * 1e9 / keys.size();
+
+  uint64_t sum = 0;
+  begin = std::chrono::steady_clock::now();
+  for (uint64_t k : hits) sum += m.find(k)->second;
+  const double hit_ns = Seconds(begin) * 1e9 / hits.size();
+
+  size_t found = 0;
+  begin = std::chrono::steady_clock::now();
+  for (uint64_t k : misses) found += m.find(k) != m.end();
+  const double miss_ns = Seconds(begin) * 1e9 / misses.size();
+
+  std::cout << std::left << std::setw(20) << name << std::right << std::fixed
+            << std::setprecision(1) << "insert " << std::setw(6) << insert_ns
+            << " ns, hit " << std::setw(6) << hit_ns << " ns, miss "
+            << std::setw(6) << miss_ns << " ns  (" << sum + found << ")"
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+  const size_t lookups = argc > 2 ? strtoull(argv[2], nullptr, 10) : 5000000;
+
+  std::mt19937_64 rng(1);
+  std::vector<uint64_t> keys(n);
+  for (auto& k : keys) k = rng() | 1;  // 奇数：一定命中
+  std::vector<uint64_t> hits(lookups), misses(lookups);
+  for (auto& k : hits) k = keys[rng() % n];
+  for (auto& k : misses) k = rng() & ~uint64_t{1};  // 偶数：一定不命中
+
+  Run<FlatHashMap<uint64_t, uint64_t>>("FlatHashMap", keys, hits, misses);
+  Run<std::unordered_map<uint64_t, uint64_t>>("std::unordered_map", keys, hits, misses);
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "perf_counter.h"
+
+using namespace absl::container_internal;
+
+// 对每个Slice<N>做一次顺序扫描，统计每个元素的耗时以及cache/TLB miss。
+//
+// 用法：./bench_layout [elements-per-array] [repeats]
+//
+// 若perf_event_open不可用（容器、虚拟机、perf_event_paranoid太高等），
+// 对应列打印"n/a"，只剩wall-clock。
+
+namespace {
+
+size_t g_elems = size_t{1} << 22;
+int g_repeats = 5;
+
+// 防止编译器把扫描优化掉；
+volatile double g_sink;
+
+void PrintHeader() {
+  std::cout << std::left << std::setw(40) << "layout" << std::setw(8)
+            << "field" << std::right << std::setw(10) << "ns/elem";
+  for (size_t e = 0; e != PerfCounters::kNumEvents; ++e) {
+    std::cout << std::setw(14) << PerfCounters::Name(e);
+  }
+  std::cout << "   (counters are per element)" << std::endl;
+}
+
+void PrintRow(const std::string& name, size_t field, double ns,
+              const PerfSample& s, size_t n) {
+  std::cout << std::left << std::setw(40) << name << std::setw(8)
+            << ("Slice<" + std::to_string(field) + ">") << std::right
+            << std::setw(10) << std::fixed << std::setprecision(3) << ns;
+  for (size_t e = 0; e != PerfCounters::kNumEvents; ++e) {
+    if (s.Valid(e)) {
+      std::cout << std::setw(14) << std::setprecision(4)
+                << s.PerElement(e, n);
+    } else {
+      std::cout << std::setw(14) << "n/a";
+    }
+  }
+  std::cout << std::endl;
+}
+
+template <size_t N, class L>
+void ScanSlice(const std::string& name, const L& layout, unsigned char* p,
+               PerfCounters& counters) {
+  auto slice = layout.template Slice<N>(p);
+  const size_t n = slice.size() * g_repeats;
+
+  auto begin = std::chrono::steady_clock::now();
+  counters.Start();
+  double sum = 0;
+  for (int r = 0; r != g_repeats; ++r) {
+    for (auto e : slice) sum += e;
+  }
+  PerfSample s = counters.Stop();
+  auto end = std::chrono::steady_clock::now();
+  g_sink = sum;
+
+  double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+  PrintRow(name, N, ns / n, s, n);
+}
+
+template <class L, size_t... I>
+void Run(const std::string& name, PerfCounters& counters,
+         std::index_sequence<I...>) {
+  const L layout(((void)I, g_elems)...);
+  unsigned char* p = static_cast<unsigned char*>(
+      aligned_alloc_posix(L::Alignment(), layout.AllocSize()));
+  // 先写一遍，让所有页都被分配（first touch），避免把page fault算进扫描里；
+  memset(p, 1, layout.AllocSize());
+
+  (ScanSlice<I>(name, layout, p, counters), ...);
+  free(p);
+}
+
+template <class... Ts>
+void Run(const std::string& name, PerfCounters& counters) {
+  Run<Layout<Ts...>>(name, counters, std::index_sequence_for<Ts...>());
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc > 1) g_elems = strtoull(argv[1], nullptr, 10);
+  if (argc > 2) g_repeats = atoi(argv[2]);
+
+  PerfCounters counters;
+  if (!counters.Available()) {
+    std::cout << "perf_event_open unavailable, reporting wall-clock only"
+              << std::endl;
+  }
+  std::cout << "elements per array: " << g_elems << ", repeats: " << g_repeats
+            << std::endl;
+
+  PrintHeader();
+  Run<char, int, double>("Layout<char, int, double>", counters);
+  Run<char, Aligned<int, 32>, double>("Layout<char, Aligned<int,32>, double>",
+                                      counters);
+  Run<double, int, char>("Layout<double, int, char>", counters);
+  Run<size_t, size_t, float, double>("Layout<size_t, size_t, float, double>",
+                                     counters);
+  return 0;
+}
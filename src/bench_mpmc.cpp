@@ -0,0 +1,130 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "layout.h"
+#include "mpmc_queue.h"
+#include "work_stealing.h"
+
+using namespace absl::container_internal;
+
+// 扩展性：总线程数从1到64（一半生产者，一半消费者；1个线程时两者各1个），
+// 生产者从Arena分配MyCompactFoo风格的记录，批量入队；消费者通过
+// StealingConsumers取记录，计算校验和。
+//
+// 用法：./bench_mpmc [records] [max-threads] [batch]
+
+namespace {
+
+using L = Layout<size_t, size_t, float, double>;
+
+struct Result {
+  double secs;
+  double checksum;
+};
+
+Result Run(size_t records, size_t producers, size_t consumers, size_t batch) {
+  Arena arena;
+  MpmcQueue<unsigned char*> queue(1 << 14);
+  StealingConsumers<unsigned char*> group(queue, consumers, batch);
+  std::atomic<size_t> done{0};
+  std::vector<double> sums(consumers * 8);  // 每个消费者一个cache line
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < producers; ++t) {
+    threads.emplace_back([&, t] {
+      const size_t first = records * t / producers;
+      const size_t last = records * (t + 1) / producers;
+      std::vector<unsigned char*> buf(batch);
+      size_t n = 0;
+      for (size_t i = first; i < last; ++i) {
+        const size_t nf = i & 7, nd = i & 3;
+        const L layout(1, 1, nf, nd);
+        unsigned char* p = arena.Allocate(layout);
+        *layout.Pointer<0>(p) = nf;
+        *layout.Pointer<1>(p) = nd;
+        float* floats = layout.Pointer<2>(p);
+        for (size_t j = 0; j < nf; ++j) floats[j] = 1;
+        double* doubles = layout.Pointer<3>(p);
+        for (size_t j = 0; j < nd; ++j) doubles[j] = 1;
+        buf[n++] = p;
+        if (n == batch || i + 1 == last) {
+          for (size_t k = 0; k < n;) {
+            size_t m = queue.EnqueueBatch(buf.data() + k, n - k);
+            if (m == 0) std::this_thread::yield();
+            k += m;
+          }
+          n = 0;
+        }
+      }
+    });
+  }
+  for (size_t w = 0; w < consumers; ++w) {
+    threads.emplace_back([&, w] {
+      double sum = 0;
+      size_t local = 0;
+      unsigned char* p;
+      while (done.load(std::memory_order_relaxed) < records) {
+        if (!group.Next(w, &p)) {
+          if (local != 0) {
+            done.fetch_add(local, std::memory_order_relaxed);
+            local = 0;
+          }
+          std::this_thread::yield();
+          continue;
+        }
+        constexpr auto partial = L::Partial(1, 1);
+        const L layout(1, 1, *partial.Pointer<0>(p), *partial.Pointer<1>(p));
+        for (float f : layout.Slice<2>(p)) sum += f;
+        for (double d : layout.Slice<3>(p)) sum += d;
+        if (++local == 64) {
+          done.fetch_add(local, std::memory_order_relaxed);
+          local = 0;
+        }
+      }
+      done.fetch_add(local, std::memory_order_relaxed);
+      sums[w * 8] = sum;
+    });
+  }
+  for (auto& t : threads) t.join();
+  auto end = std::chrono::steady_clock::now();
+
+  Result r{std::chrono::duration<double>(end - begin).count(), 0};
+  for (size_t w = 0; w < consumers; ++w) r.checksum += sums[w * 8];
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+  const size_t max_threads = argc > 2 ? strtoull(argv[2], nullptr, 10) : 64;
+  const size_t batch = argc > 3 ? strtoull(argv[3], nullptr, 10) : 32;
+
+  std::cout << "records: " << records << ", batch: " << batch
+            << ", hardware threads: " << std::thread::hardware_concurrency()
+            << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(10) << "producers"
+            << std::setw(10) << "consumers" << std::setw(14) << "Mrecords/s"
+            << std::setw(12) << "checksum" << std::endl;
+  for (size_t t = 1; t <= max_threads; t *= 2) {
+    const size_t producers = t > 1 ? t / 2 : 1;
+    const size_t consumers = t > 1 ? t - producers : 1;
+    Result r = Run(records, producers, consumers, batch);
+    std::cout << std::setw(8) << t << std::setw(10) << producers
+              << std::setw(10) << consumers << std::setw(14) << std::fixed
+              << std::setprecision(2) << records / r.secs / 1e6
+              << std::setw(12) << std::setprecision(0) << r.checksum
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "layout.h"
+#include "parallel_columns.h"
+#include "thread_pool.h"
+
+using namespace absl::container_internal;
+
+// 列上的并行算法：线程数从1到max-threads，对每个算法输出吞吐（按读写的列
+// 字节数计算的GB/s）以及相对1个线程的加速比。数据大小应远大于LLC，这样
+// 测的是内存带宽的扩展性。
+//
+// 用法：./bench_parallel [rows] [max-threads]
+
+namespace {
+
+using L = Layout<Aligned<uint64_t, 64>, Aligned<double, 64>, Aligned<float, 64>>;
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+template <class Fn>
+double Time(Fn fn) {
+  auto begin = std::chrono::steady_clock::now();
+  fn();
+  return Seconds(begin);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+  const size_t max_threads = argc > 2 ? strtoull(argv[2], nullptr, 10) : 64;
+
+  const L layout(n, n, n);
+  unsigned char* p = static_cast<unsigned char*>(
+      ::operator new(layout.AllocSize(), std::align_val_t{L::Alignment()}));
+  const auto rows = layout.Zip<0, 1, 2>(p);
+  const double row_bytes = sizeof(uint64_t) + sizeof(double) + sizeof(float);
+  const double gb = n * row_bytes / 1e9;
+
+  const char* names[] = {"for_each", "transform", "reduce", "sort_by_key",
+                         "partition"};
+  double base[5] = {};
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    ThreadPool pool(threads);
+    // 每轮重新生成数据，排序的输入不受上一轮影响；
+    ParallelForEach(pool, rows, [](uint64_t& id, double& x, float& y) {
+      // 行内容由地址决定：与线程数无关；
+      const uint64_t h = reinterpret_cast<uintptr_t>(&id) * 0x9e3779b97f4a7c15;
+      id = h >> 20;
+      x = static_cast<double>(h & 1023);
+      y = 1.0f;
+    });
+
+    double secs[5];
+    // for_each：读写3列；
+    secs[0] = Time([&] {
+      ParallelForEach(pool, rows, [](uint64_t& id, double& x, float& y) {
+        x += y;
+        ++id;
+      });
+    }) / (2 * gb);
+    // transform：读2列，写1列；
+    secs[1] = Time([&] {
+      ParallelTransform(pool, layout.Zip<0, 1>(p), layout.Pointer<2>(p),
+                        [](uint64_t id, double x) { return float(x + id); });
+    }) / gb;
+    // reduce：读2列；
+    double sum = 0;
+    secs[2] = Time([&] {
+      sum = ParallelReduce(pool, layout.Zip<1, 2>(p), 0.0,
+                           [](double x, float y) { return x * y; },
+                           std::plus<>());
+    }) / ((sizeof(double) + sizeof(float)) * n / 1e9);
+    // sort_by_key，partition：按读写所有列一次计；
+    secs[3] = Time([&] { ParallelSortByKey<0>(pool, rows); }) / gb;
+    size_t evens = 0;
+    secs[4] = Time([&] {
+      evens = ParallelPartition(pool, rows, [](uint64_t id, double, float) {
+        return id % 2 == 0;
+      });
+    }) / gb;
+
+    std::cout << std::setw(2) << threads << " threads:" << std::fixed
+              << std::setprecision(2);
+    for (int a = 0; a < 5; ++a) {
+      const double gbps = 1 / secs[a];
+      if (threads == 1) base[a] = gbps;
+      std::cout << "  " << names[a] << " " << std::setw(5) << gbps << " GB/s (x"
+                << std::setprecision(1) << gbps / base[a] << ")"
+                << std::setprecision(2);
+    }
+    std::cout << "  [" << sum << ", " << evens << "]" << std::endl;
+  }
+  ::operator delete(p, std::align_val_t{L::Alignment()});
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "layout.h"
+#include "parallel_columns.h"
+#include "radix_sort.h"
+#include "thread_pool.h"
+
+using namespace absl::container_internal;
+
+// 按key列排序、其它列跟着移动：归并排序ParallelSortByKey与基数排序
+// ParallelRadixSortByKey对比。线程数从1到max-threads，输出每秒排序的行数
+// 以及相对1个线程的加速比。
+//
+// 用法：./bench_radix [rows] [max-threads]
+
+namespace {
+
+using L = Layout<Aligned<uint64_t, 64>, Aligned<double, 64>, Aligned<float, 64>>;
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+template <class Fn>
+double Time(Fn fn) {
+  auto begin = std::chrono::steady_clock::now();
+  fn();
+  return Seconds(begin);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+  const size_t max_threads = argc > 2 ? strtoull(argv[2], nullptr, 10) : 64;
+
+  const L layout(n, n, n);
+  unsigned char* p = static_cast<unsigned char*>(
+      ::operator new(layout.AllocSize(), std::align_val_t{L::Alignment()}));
+  const auto rows = layout.Zip<0, 1, 2>(p);
+
+  // 每次排序前重新生成数据：行内容只由行号决定；
+  const auto fill = [&](ThreadPool& pool) {
+    ParallelForEach(pool, rows, [&](uint64_t& id, double& x, float& y) {
+      const uint64_t i = &id - layout.Pointer<0>(p);
+      id = (i + 1) * 0x9e3779b97f4a7c15;
+      x = static_cast<double>(i);
+      y = 1.0f;
+    });
+  };
+
+  const char* names[] = {"merge", "radix"};
+  double base[2] = {};
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    ThreadPool pool(threads);
+    double secs[2];
+    fill(pool);
+    secs[0] = Time([&] { ParallelSortByKey<0>(pool, rows); });
+    fill(pool);
+    secs[1] = Time([&] { ParallelRadixSortByKey<0>(pool, rows); });
+
+    std::cout << std::setw(2) << threads << " threads:" << std::fixed
+              << std::setprecision(1);
+    for (int a = 0; a < 2; ++a) {
+      const double mrows = n / secs[a] / 1e6;
+      if (threads == 1) base[a] = mrows;
+      std::cout << "  " << names[a] << " " << std::setw(7) << mrows
+                << " Mrows/s (x" << mrows / base[a] << ")";
+    }
+    std::cout << std::endl;
+  }
+  ::operator delete(p, std::align_val_t{L::Alignment()});
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "layout.h"
+#include "spsc_ring.h"
+
+using namespace absl::container_internal;
+
+// 跨核吞吐：生产者和消费者分别绑到两个CPU上，传递MyCompactFoo风格的变长记录；
+//
+// 用法：./bench_ring [records] [producer-cpu] [consumer-cpu] [ring-bytes]
+
+namespace {
+
+using L = Layout<size_t, size_t, float, double>;
+
+void Pin(int cpu) {
+#if defined(__linux__)
+  if (cpu < 0) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+  const int producer_cpu = argc > 2 ? atoi(argv[2]) : 0;
+  const int consumer_cpu =
+      argc > 3 ? atoi(argv[3])
+               : (std::thread::hardware_concurrency() > 1 ? 1 : -1);
+  const size_t capacity = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1 << 16;
+
+  SpscRing ring(capacity);
+  size_t bytes = 0;
+
+  auto begin = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    Pin(producer_cpu);
+    for (size_t i = 0; i < n; ++i) {
+      const size_t nf = i & 7, nd = i & 3;
+      const L layout(1, 1, nf, nd);
+      unsigned char* p;
+      while ((p = ring.Reserve(layout)) == nullptr) std::this_thread::yield();
+      *layout.Pointer<0>(p) = nf;
+      *layout.Pointer<1>(p) = nd;
+      float* floats = layout.Pointer<2>(p);
+      for (size_t j = 0; j < nf; ++j) floats[j] = j;
+      double* doubles = layout.Pointer<3>(p);
+      for (size_t j = 0; j < nd; ++j) doubles[j] = j;
+      ring.Commit();
+    }
+  });
+
+  Pin(consumer_cpu);
+  double sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const unsigned char* p;
+    size_t size;
+    while ((p = ring.Peek(&size)) == nullptr) std::this_thread::yield();
+    constexpr auto partial = L::Partial(1, 1);
+    const L layout(1, 1, *partial.Pointer<0>(p), *partial.Pointer<1>(p));
+    for (float f : layout.Slice<2>(p)) sum += f;
+    for (double d : layout.Slice<3>(p)) sum += d;
+    bytes += size;
+    ring.Release();
+  }
+  producer.join();
+  auto end = std::chrono::steady_clock::now();
+
+  double secs = std::chrono::duration<double>(end - begin).count();
+  std::cout << "records: " << n << ", ring: " << capacity << " B, cpus "
+            << producer_cpu << " -> " << consumer_cpu << std::endl;
+  std::cout << "ns/record: " << secs * 1e9 / n
+            << ", Mrecords/s: " << n / secs / 1e6
+            << ", MB/s: " << bytes / secs / 1e6 << " (checksum " << sum << ")"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "skiplist.h"
+
+using namespace absl::container_internal;
+
+// 并发有序索引：ConcurrentSkipList（Arena中的Layout节点，无锁CAS插入，
+// 查找不加锁）对比用一个std::mutex保护的std::map。线程数从1到max-threads，
+// 各线程先插入自己那份随机key，再做随机查找；输出总吞吐。
+//
+// 用法：./bench_skiplist [elements] [lookups] [max-threads]
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+// 所有线程同时开始执行`fn(t)`，返回耗时；
+template <class Fn>
+double RunThreads(size_t threads, Fn fn) {
+  std::vector<std::thread> ts;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < threads; ++t) ts.emplace_back(fn, t);
+  for (auto& th : ts) th.join();
+  return Seconds(begin);
+}
+
+void Print(const char* name, size_t threads, double insert_mops,
+           double find_mops, uint64_t check) {
+  std::cout << std::left << std::setw(12) << name << std::right << std::setw(2)
+            << threads << " threads: " << std::fixed << std::setprecision(2)
+            << "insert " << std::setw(6) << insert_mops << " Mops/s, find "
+            << std::setw(6) << find_mops << " Mops/s  (" << check << ")"
+            << std::endl;
+}
+
+struct LockedMap {
+  std::mutex mu;
+  std::map<uint64_t, uint64_t> m;
+};
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+  const size_t lookups = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000000;
+  const size_t max_threads = argc > 3 ? strtoull(argv[3], nullptr, 10) : 8;
+
+  std::mt19937_64 rng(1);
+  std::vector<uint64_t> keys(n), probes(lookups);
+  for (auto& k : keys) k = rng();
+  for (auto& k : probes) k = keys[rng() % n];
+
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    const auto share = [&](const std::vector<uint64_t>& v, size_t t) {
+      return std::pair(v.begin() + v.size() * t / threads,
+                       v.begin() + v.size() * (t + 1) / threads);
+    };
+    std::vector<uint64_t> sums(threads * 8);  // 每个线程一个cache line
+    {
+      Arena arena;
+      ConcurrentSkipList<uint64_t, uint64_t> s(arena);
+      const double insert_secs = RunThreads(threads, [&](size_t t) {
+        auto [first, last] = share(keys, t);
+        for (auto it = first; it != last; ++it) s.Insert(*it, *it);
+      });
+      const double find_secs = RunThreads(threads, [&](size_t t) {
+        auto [first, last] = share(probes, t);
+        uint64_t sum = 0;
+        for (auto it = first; it != last; ++it) sum += *s.Find(*it);
+        sums[t * 8] = sum;
+      });
+      uint64_t check = 0;
+      for (size_t t = 0; t < threads; ++t) check += sums[t * 8];
+      Print("SkipList", threads, n / insert_secs / 1e6,
+            lookups / find_secs / 1e6, check);
+    }
+    {
+      LockedMap lm;
+      const double insert_secs = RunThreads(threads, [&](size_t t) {
+        auto [first, last] = share(keys, t);
+        for (auto it = first; it != last; ++it) {
+          std::lock_guard<std::mutex> lock(lm.mu);
+          lm.m.emplace(*it, *it);
+        }
+      });
+      const double find_secs = RunThreads(threads, [&](size_t t) {
+        auto [first, last] = share(probes, t);
+        uint64_t sum = 0;
+        for (auto it = first; it != last; ++it) {
+          std::lock_guard<std::mutex> lock(lm.mu);
+          sum += lm.m.find(*it)->second;
+        }
+        sums[t * 8] = sum;
+      });
+      uint64_t check = 0;
+      for (size_t t = 0; t < threads; ++t) check += sums[t * 8];
+      Print("mutex+map", threads, n / insert_secs / 1e6,
+            lookups / find_secs / 1e6, check);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,321 @@
+// A view of an array of `K`-bit unsigned values packed into 64-bit words.
+//
+// This is what `Layout<..., Bits<K>, ...>::Slice<N>(p)` returns. Value `i`
+// occupies bits `[i * K, (i + 1) * K)` of the word array, least significant
+// bit first, so a value may straddle two words when `K` doesn't divide 64.
+//
+//   using L = Layout<Field<"valid", Bits<1>>, Field<"state", Bits<3>>>;
+//   const L layout(n, n);                     // ceil(n / 64) + ceil(3n / 64)
+//                                             // words instead of 2n bytes
+//   auto valid = layout.Slice<"valid">(p);    // BitSpan<1, uint64_t>
+//   auto state = layout.Slice<"state">(p);    // BitSpan<3, uint64_t>
+//   valid[i] = true;
+//   state[i] = 5;
+//   size_t live = valid.Count();              // popcount
+//   size_t k = valid.Rank(i);                 // ones in [0, i)
+//   size_t j = valid.Select(k);               // index of the k-th one
+//   uint8_t bytes[256];
+//   state.Unpack(0, 256, bytes);              // values 0..255 as bytes
+//
+// `Rank()`, `Select()` and `Count()` are only defined for bitmaps (`K == 1`).
+// They work a word at a time with popcount; `Select()` finishes inside the
+// word with `pdep` + `tzcnt` when BMI2 is available. `Unpack()` of a bitmap
+// to bytes expands 32 bits per AVX2 step.
+
+#ifndef ABSL_CONTAINER_INTERNAL_BIT_SPAN_H_
+#define ABSL_CONTAINER_INTERNAL_BIT_SPAN_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <compare>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace absl {
+namespace container_internal {
+namespace bit_span_internal {
+
+// Index of the `k`-th (zero-based) set bit of `w`.
+//
+// Requires: `k < popcount(w)`.
+inline unsigned SelectInWord(uint64_t w, unsigned k) {
+  for (; k != 0; --k) w &= w - 1;
+  return __builtin_ctzll(w);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("bmi2"))) inline unsigned SelectInWordBmi2(uint64_t w,
+                                                                  unsigned k) {
+  return __builtin_ctzll(_pdep_u64(uint64_t{1} << k, w));
+}
+
+// Writes bits [0, 32) of `bits` as 32 bytes of 0 or 1.
+__attribute__((target("avx2"))) inline void ExpandBits32(uint32_t bits,
+                                                         uint8_t* out) {
+  // Byte j of the result takes byte j / 8 of `bits`, then keeps bit j % 8.
+  const __m256i spread = _mm256_setr_epi64x(
+      0x0000000000000000, 0x0101010101010101, 0x0202020202020202,
+      0x0303030303030303);
+  const __m256i select = _mm256_set1_epi64x(0x8040201008040201);
+  __m256i v = _mm256_set1_epi32(static_cast<int>(bits));
+  v = _mm256_shuffle_epi8(v, spread);
+  v = _mm256_cmpeq_epi8(_mm256_and_si256(v, select), select);
+  v = _mm256_and_si256(v, _mm256_set1_epi8(1));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+}
+
+inline bool HasBmi2() {
+  static const bool kHas = __builtin_cpu_supports("bmi2");
+  return kHas;
+}
+
+inline bool HasAvx2() {
+  static const bool kHas = __builtin_cpu_supports("avx2");
+  return kHas;
+}
+#endif
+
+}  // namespace bit_span_internal
+
+// `Word` is `uint64_t` or `const uint64_t`.
+template <size_t K, class Word>
+class BitSpan {
+  static_assert(K > 0 && K <= 64, "Bits<K> requires 0 < K <= 64");
+  static_assert(std::is_same_v<std::remove_const_t<Word>, uint64_t>,
+                "BitSpan is a view of uint64_t words");
+
+  static constexpr size_t kBits = 64;
+  static constexpr uint64_t kMask = K == 64 ? ~uint64_t{0}
+                                            : (uint64_t{1} << K) - 1;
+
+ public:
+  // A reference to value `i`, returned by `operator[]` of a mutable span.
+  class Reference {
+   public:
+    operator uint64_t() const { return Get(words_, i_); }
+    Reference& operator=(uint64_t v) {
+      Set(words_, i_, v);
+      return *this;
+    }
+    Reference& operator=(const Reference& other) {
+      return *this = static_cast<uint64_t>(other);
+    }
+
+   private:
+    friend class BitSpan;
+    Reference(Word* words, size_t i) : words_(words), i_(i) {}
+    Word* words_;
+    size_t i_;
+  };
+
+  class const_iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = uint64_t;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = uint64_t;
+
+    const_iterator() = default;
+    uint64_t operator*() const { return Get(words_, i_); }
+    uint64_t operator[](difference_type d) const {
+      return Get(words_, i_ + d);
+    }
+    const_iterator& operator++() { ++i_; return *this; }
+    const_iterator operator++(int) { auto t = *this; ++i_; return t; }
+    const_iterator& operator--() { --i_; return *this; }
+    const_iterator operator--(int) { auto t = *this; --i_; return t; }
+    const_iterator& operator+=(difference_type d) { i_ += d; return *this; }
+    const_iterator& operator-=(difference_type d) { i_ -= d; return *this; }
+    friend const_iterator operator+(const_iterator it, difference_type d) {
+      return it += d;
+    }
+    friend const_iterator operator+(difference_type d, const_iterator it) {
+      return it += d;
+    }
+    friend const_iterator operator-(const_iterator it, difference_type d) {
+      return it -= d;
+    }
+    friend difference_type operator-(const const_iterator& a,
+                                     const const_iterator& b) {
+      return static_cast<difference_type>(a.i_ - b.i_);
+    }
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.i_ == b.i_;
+    }
+    friend auto operator<=>(const const_iterator& a, const const_iterator& b) {
+      return a.i_ <=> b.i_;
+    }
+
+   private:
+    friend class BitSpan;
+    const_iterator(const uint64_t* words, size_t i) : words_(words), i_(i) {}
+    const uint64_t* words_ = nullptr;
+    size_t i_ = 0;
+  };
+
+  BitSpan() = default;
+  BitSpan(Word* words, size_t size) : words_(words), size_(size) {}
+
+  // Number of values.
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // The underlying words; `num_words()` of them are covered by the span.
+  Word* data() const { return words_; }
+  size_t num_words() const { return (size_ * K + kBits - 1) / kBits; }
+
+  static constexpr size_t bits_per_value() { return K; }
+
+  uint64_t get(size_t i) const {
+    assert(i < size_);
+    return Get(words_, i);
+  }
+
+  // Stores the low `K` bits of `v`.
+  void set(size_t i, uint64_t v) const {
+    static_assert(!std::is_const_v<Word>, "set() on a const BitSpan");
+    assert(i < size_);
+    Set(words_, i, v);
+  }
+
+  uint64_t operator[](size_t i) const
+    requires std::is_const_v<Word>
+  {
+    return get(i);
+  }
+  Reference operator[](size_t i) const
+    requires(!std::is_const_v<Word>)
+  {
+    return Reference(words_, i);
+  }
+
+  const_iterator begin() const { return {words_, 0}; }
+  const_iterator end() const { return {words_, size_}; }
+
+  // Sets all values to 0, including the unused bits of the last word.
+  void Clear() const {
+    static_assert(!std::is_const_v<Word>, "Clear() on a const BitSpan");
+    for (size_t w = 0; w != num_words(); ++w) words_[w] = 0;
+  }
+
+  // Number of set bits.
+  size_t Count() const
+    requires(K == 1)
+  {
+    return Rank(size_);
+  }
+
+  // Number of set bits in `[0, i)`.
+  //
+  // Requires: `i <= size()`.
+  size_t Rank(size_t i) const
+    requires(K == 1)
+  {
+    assert(i <= size_);
+    size_t n = 0;
+    const size_t full = i / kBits;
+    for (size_t w = 0; w != full; ++w) n += __builtin_popcountll(words_[w]);
+    if (i % kBits != 0) {
+      n += __builtin_popcountll(words_[full] &
+                                ((uint64_t{1} << (i % kBits)) - 1));
+    }
+    return n;
+  }
+
+  // Index of the `k`-th (zero-based) set bit, or `size()` if there are at
+  // most `k` set bits.
+  size_t Select(size_t k) const
+    requires(K == 1)
+  {
+    const size_t words = num_words();
+    for (size_t w = 0; w != words; ++w) {
+      uint64_t word = words_[w];
+      if (w + 1 == words && size_ % kBits != 0) {
+        word &= (uint64_t{1} << (size_ % kBits)) - 1;
+      }
+      const size_t ones = __builtin_popcountll(word);
+      if (k < ones) {
+        const unsigned k32 = static_cast<unsigned>(k);
+#if defined(__x86_64__)
+        if (bit_span_internal::HasBmi2()) {
+          return w * kBits + bit_span_internal::SelectInWordBmi2(word, k32);
+        }
+#endif
+        return w * kBits + bit_span_internal::SelectInWord(word, k32);
+      }
+      k -= ones;
+    }
+    return size_;
+  }
+
+  // Writes values `[begin, begin + n)` to `out[0, n)`. `Out` is an unsigned
+  // integer type wide enough for `K` bits.
+  //
+  // Requires: `begin + n <= size()`.
+  template <class Out>
+  void Unpack(size_t begin, size_t n, Out* out) const {
+    static_assert(std::is_unsigned_v<Out> && sizeof(Out) * 8 >= K,
+                  "Unpack() requires an unsigned type of at least K bits");
+    assert(begin + n <= size_);
+    size_t i = 0;
+#if defined(__x86_64__)
+    if constexpr (K == 1 && sizeof(Out) == 1) {
+      if (bit_span_internal::HasAvx2()) {
+        for (; i + 32 <= n; i += 32) {
+          bit_span_internal::ExpandBits32(Bits32(begin + i), out + i);
+        }
+      }
+    }
+#endif
+    for (; i != n; ++i) out[i] = static_cast<Out>(get(begin + i));
+  }
+
+  // Sets values `[begin, begin + n)` to the low `K` bits of `in[0, n)`.
+  template <class In>
+  void Pack(size_t begin, size_t n, const In* in) const {
+    static_assert(!std::is_const_v<Word>, "Pack() on a const BitSpan");
+    assert(begin + n <= size_);
+    for (size_t i = 0; i != n; ++i) set(begin + i, static_cast<uint64_t>(in[i]));
+  }
+
+ private:
+  static uint64_t Get(const uint64_t* words, size_t i) {
+    const size_t bit = i * K, w = bit / kBits, s = bit % kBits;
+    uint64_t v = words[w] >> s;
+    if (s + K > kBits) v |= words[w + 1] << (kBits - s);
+    return v & kMask;
+  }
+
+  static void Set(uint64_t* words, size_t i, uint64_t v) {
+    v &= kMask;
+    const size_t bit = i * K, w = bit / kBits, s = bit % kBits;
+    words[w] = (words[w] & ~(kMask << s)) | v << s;
+    if (s + K > kBits) {
+      const uint64_t hi = (uint64_t{1} << (s + K - kBits)) - 1;
+      words[w + 1] = (words[w + 1] & ~hi) | v >> (kBits - s);
+    }
+  }
+
+  // Bits `[bit, bit + 32)` of a bitmap.
+  uint32_t Bits32(size_t bit) const {
+    const size_t w = bit / kBits, s = bit % kBits;
+    uint64_t v = words_[w] >> s;
+    if (s > kBits - 32) v |= words_[w + 1] << (kBits - s);
+    return static_cast<uint32_t>(v);
+  }
+
+  Word* words_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_BIT_SPAN_H_
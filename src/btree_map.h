@@ -0,0 +1,437 @@
+// An in-memory B+tree whose nodes are `Layout` blocks.
+//
+//   BTreeMap<int64_t, double> m;               // 512-byte nodes
+//   m.insert(42, 1.5);
+//   if (auto it = m.find(42); it != m.end()) use(it.value());
+//   for (auto it = m.lower_bound(10); it != m.end() && it.key() < 20; ++it)
+//     ...
+//   m.Scan(10, 20, [](int64_t k, double& v) { ... });   // keys in [10, 20)
+//
+// Like upstream Abseil's btree (`Layout<node*, field_type, slot_type,
+// node*>`), a node is one allocation whose arrays are described by a
+// `Layout`:
+//
+//   leaf:     Layout<NodeHeader, K, V>(1, kLeafCapacity, kLeafCapacity)
+//   internal: Layout<NodeHeader, K, Node*>(1, kInnerCapacity,
+//                                          kInnerCapacity + 1)
+//
+// The capacities are the largest that fit the node in `kNodeBytes` (256 to
+// 1024; 512 by default, i.e. 8 cache lines), and nodes are cache-line
+// aligned. Keys are a separate contiguous array, so the position of a key in
+// a node is found by counting the keys that are smaller: no branches, and 4
+// (8) 64-bit (32-bit) keys per AVX2 compare. A lookup touches one node per
+// level: 4 or 5 nodes for 1M 8-byte keys. A node that overflows while
+// appending keeps its elements and starts an empty sibling, so keys inserted
+// in increasing order fill the nodes instead of leaving them half empty.
+//
+// Leaves are linked, so a range scan streams through the key and value
+// arrays of consecutive leaves.
+//
+// Keys must be integers or floating point and values trivially copyable;
+// elements are moved around with `memmove`. Iterators are invalidated by
+// insertion and erasure. `erase()` doesn't merge underfull nodes: the tree
+// never shrinks until `clear()`, but lookups stay O(log n) in the peak size.
+
+#ifndef ABSL_CONTAINER_INTERNAL_BTREE_MAP_H_
+#define ABSL_CONTAINER_INTERNAL_BTREE_MAP_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+namespace btree_internal {
+
+struct NodeHeader {
+  uint32_t count;       // keys in the node
+  uint32_t leaf;        // 1 for leaves
+  unsigned char* next;  // next leaf, or nullptr
+};
+
+// Largest capacity `c` such that `L(1, c, c + Extra).AllocSize() <= bytes`.
+template <class L, size_t Extra>
+constexpr size_t FitCapacity(size_t bytes) {
+  size_t c = 0;
+  while (L(1, c + 1, c + 1 + Extra).AllocSize() <= bytes) ++c;
+  return c;
+}
+
+// Number of `keys[0, n)` that are less than `k` (`kOrEqual`: not greater).
+template <bool kOrEqual, class K>
+size_t CountScalar(const K* keys, size_t n, K k) {
+  size_t c = 0;
+  for (size_t i = 0; i != n; ++i) c += kOrEqual ? keys[i] <= k : keys[i] < k;
+  return c;
+}
+
+#if defined(__x86_64__)
+inline bool HasAvx2() {
+  static const bool kHas = __builtin_cpu_supports("avx2");
+  return kHas;
+}
+
+// `CountScalar()` for 4- and 8-byte integers: compares 32 bytes of keys at a
+// time. Unsigned keys are compared as signed after flipping the top bit.
+template <bool kOrEqual, class K>
+__attribute__((target("avx2"))) size_t CountAvx2(const K* keys, size_t n,
+                                                 K k) {
+  constexpr size_t kLanes = 32 / sizeof(K);
+  using S = std::make_signed_t<K>;
+  constexpr S kFlip = std::is_signed_v<K> ? 0 : std::numeric_limits<S>::min();
+  const S sk = static_cast<S>(k) ^ kFlip;
+  size_t c = 0, i = 0;
+  if constexpr (sizeof(K) == 8) {
+    const __m256i flip = _mm256_set1_epi64x(kFlip);
+    const __m256i key = _mm256_set1_epi64x(sk);
+    for (; i + kLanes <= n; i += kLanes) {
+      const __m256i v = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip);
+      // v < k, or !(v > k) for v <= k.
+      const __m256i m = kOrEqual ? _mm256_cmpgt_epi64(v, key)
+                                 : _mm256_cmpgt_epi64(key, v);
+      const int bits = _mm256_movemask_pd(_mm256_castsi256_pd(m));
+      c += kOrEqual ? kLanes - __builtin_popcount(bits)
+                    : __builtin_popcount(bits);
+    }
+  } else {
+    const __m256i flip = _mm256_set1_epi32(kFlip);
+    const __m256i key = _mm256_set1_epi32(sk);
+    for (; i + kLanes <= n; i += kLanes) {
+      const __m256i v = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip);
+      const __m256i m = kOrEqual ? _mm256_cmpgt_epi32(v, key)
+                                 : _mm256_cmpgt_epi32(key, v);
+      const int bits = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+      c += kOrEqual ? kLanes - __builtin_popcount(bits)
+                    : __builtin_popcount(bits);
+    }
+  }
+  return c + CountScalar<kOrEqual>(keys + i, n - i, k);
+}
+#endif
+
+template <bool kOrEqual, class K>
+size_t Count(const K* keys, size_t n, K k) {
+#if defined(__x86_64__)
+  if constexpr (std::is_integral_v<K> && (sizeof(K) == 4 || sizeof(K) == 8)) {
+    if (HasAvx2()) return CountAvx2<kOrEqual>(keys, n, k);
+  }
+#endif
+  return CountScalar<kOrEqual>(keys, n, k);
+}
+
+}  // namespace btree_internal
+
+template <class K, class V, size_t kNodeBytes = 512>
+class BTreeMap {
+  static_assert(std::is_arithmetic_v<K>, "Keys must be integers or floats");
+  static_assert(std::is_trivially_copyable_v<V>,
+                "Values must be trivially copyable");
+  static_assert(kNodeBytes >= 256 && kNodeBytes <= 1024,
+                "Nodes should be 256 to 1024 bytes");
+
+  using Header = btree_internal::NodeHeader;
+  using Node = unsigned char;
+
+ public:
+  using LeafLayout = Layout<Header, K, V>;
+  using InnerLayout = Layout<Header, K, Node*>;
+
+  static constexpr size_t kLeafCapacity =
+      btree_internal::FitCapacity<LeafLayout, 0>(kNodeBytes);
+  static constexpr size_t kInnerCapacity =
+      btree_internal::FitCapacity<InnerLayout, 1>(kNodeBytes);
+  static_assert(kLeafCapacity >= 4 && kInnerCapacity >= 4,
+                "Elements too large for the node size");
+
+  static constexpr LeafLayout kLeaf{1, kLeafCapacity, kLeafCapacity};
+  static constexpr InnerLayout kInner{1, kInnerCapacity, kInnerCapacity + 1};
+
+  // Position of an element: a leaf and an index in it.
+  class iterator {
+   public:
+    iterator() = default;
+    const K& key() const { return Keys(leaf_)[i_]; }
+    V& value() const { return Values(leaf_)[i_]; }
+    std::pair<const K&, V&> operator*() const { return {key(), value()}; }
+    iterator& operator++() {
+      ++i_;
+      SkipEmpty();
+      return *this;
+    }
+    bool operator==(const iterator& o) const {
+      return leaf_ == o.leaf_ && i_ == o.i_;
+    }
+    bool operator!=(const iterator& o) const { return !(*this == o); }
+
+   private:
+    friend class BTreeMap;
+    iterator(Node* leaf, size_t i) : leaf_(leaf), i_(i) { SkipEmpty(); }
+
+    // Moves past the end of a leaf (and over empty leaves) to the next one.
+    void SkipEmpty() {
+      while (leaf_ != nullptr && i_ == Hdr(leaf_).count) {
+        leaf_ = Hdr(leaf_).next;
+        i_ = 0;
+      }
+    }
+
+    Node* leaf_ = nullptr;
+    size_t i_ = 0;
+  };
+
+  BTreeMap() = default;
+  BTreeMap(const BTreeMap&) = delete;
+  BTreeMap& operator=(const BTreeMap&) = delete;
+  BTreeMap(BTreeMap&& other) noexcept
+      : root_(std::exchange(other.root_, nullptr)),
+        first_(std::exchange(other.first_, nullptr)),
+        height_(std::exchange(other.height_, 0)),
+        size_(std::exchange(other.size_, 0)),
+        nodes_(std::exchange(other.nodes_, 0)) {}
+  BTreeMap& operator=(BTreeMap&& other) noexcept {
+    if (this != &other) {
+      clear();
+      root_ = std::exchange(other.root_, nullptr);
+      first_ = std::exchange(other.first_, nullptr);
+      height_ = std::exchange(other.height_, 0);
+      size_ = std::exchange(other.size_, 0);
+      nodes_ = std::exchange(other.nodes_, 0);
+    }
+    return *this;
+  }
+  ~BTreeMap() { clear(); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // Levels of internal nodes above the leaves.
+  size_t height() const { return height_; }
+  size_t node_count() const { return nodes_; }
+
+  iterator begin() const { return iterator(first_, 0); }
+  iterator end() const { return iterator(); }
+
+  // First element with a key not less than `k`.
+  iterator lower_bound(K k) const {
+    if (root_ == nullptr) return end();
+    Node* leaf = FindLeaf(k);
+    return iterator(leaf, btree_internal::Count<false>(
+                              Keys(leaf), Hdr(leaf).count, k));
+  }
+
+  iterator find(K k) const {
+    iterator it = lower_bound(k);
+    return it != end() && it.key() == k ? it : end();
+  }
+
+  bool contains(K k) const { return find(k) != end(); }
+
+  // Inserts `(k, v)` unless `k` is present. Returns the element with key `k`
+  // and whether it was inserted.
+  std::pair<iterator, bool> insert(K k, const V& v) {
+    if (root_ == nullptr) {
+      root_ = first_ = NewNode(true);
+    }
+    Split split;
+    const std::pair<iterator, bool> res = Insert(root_, height_, k, v, &split);
+    if (split.right != nullptr) {
+      // The root split: grow a level.
+      Node* root = NewNode(false);
+      Hdr(root).count = 1;
+      Keys(root)[0] = split.key;
+      Children(root)[0] = root_;
+      Children(root)[1] = split.right;
+      root_ = root;
+      ++height_;
+    }
+    size_ += res.second;
+    return res;
+  }
+
+  V& operator[](K k) { return insert(k, V()).first.value(); }
+
+  size_t erase(K k) {
+    iterator it = find(k);
+    if (it == end()) return 0;
+    Header& h = Hdr(it.leaf_);
+    const size_t tail = h.count - it.i_ - 1;
+    memmove(Keys(it.leaf_) + it.i_, Keys(it.leaf_) + it.i_ + 1,
+            tail * sizeof(K));
+    memmove(Values(it.leaf_) + it.i_, Values(it.leaf_) + it.i_ + 1,
+            tail * sizeof(V));
+    --h.count;
+    --size_;
+    return 1;
+  }
+
+  // Calls `fn(key, value&)` for the keys in `[lo, hi)`, in order, streaming
+  // through the key and value arrays of the leaves.
+  template <class Fn>
+  void Scan(K lo, K hi, Fn&& fn) const {
+    if (root_ == nullptr || !(lo < hi)) return;
+    Node* leaf = FindLeaf(lo);
+    size_t i = btree_internal::Count<false>(Keys(leaf), Hdr(leaf).count, lo);
+    for (; leaf != nullptr; leaf = Hdr(leaf).next, i = 0) {
+      const K* keys = Keys(leaf);
+      V* values = Values(leaf);
+      const size_t n = Hdr(leaf).count;
+      // Keys below `hi` in this leaf: all of them unless it's the last leaf.
+      const size_t end = n != 0 && keys[n - 1] < hi
+                             ? n
+                             : btree_internal::Count<false>(keys, n, hi);
+      for (; i < end; ++i) fn(keys[i], values[i]);
+      if (end != n) return;
+    }
+  }
+
+  void clear() {
+    if (root_ != nullptr) Free(root_, height_);
+    root_ = first_ = nullptr;
+    height_ = size_ = nodes_ = 0;
+  }
+
+ private:
+  // A node that split off to the right of a child, and the smallest key in
+  // it (the separator).
+  struct Split {
+    K key{};
+    Node* right = nullptr;
+  };
+
+  static constexpr size_t kAlignment =
+      LeafLayout::Alignment() > 64 ? LeafLayout::Alignment() : 64;
+
+  // The header and the keys are at the same offsets in both kinds of node.
+  static_assert(kLeaf.template Offset<1>() == kInner.template Offset<1>());
+  static Header& Hdr(Node* n) { return *kLeaf.template Pointer<0>(n); }
+  static K* Keys(Node* n) { return kLeaf.template Pointer<1>(n); }
+  static V* Values(Node* n) { return kLeaf.template Pointer<2>(n); }
+  static Node** Children(Node* n) { return kInner.template Pointer<2>(n); }
+
+  Node* NewNode(bool leaf) {
+    const size_t size = leaf ? kLeaf.AllocSize() : kInner.AllocSize();
+    Node* n = static_cast<Node*>(
+        ::operator new(size, std::align_val_t{kAlignment}));
+    Hdr(n) = Header{0, leaf, nullptr};
+    ++nodes_;
+    return n;
+  }
+
+  void Free(Node* n, size_t height) {
+    if (height != 0) {
+      for (size_t i = 0; i <= Hdr(n).count; ++i) {
+        Free(Children(n)[i], height - 1);
+      }
+    }
+    ::operator delete(n, std::align_val_t{kAlignment});
+  }
+
+  Node* FindLeaf(K k) const {
+    Node* n = root_;
+    for (size_t h = height_; h != 0; --h) {
+      n = Children(n)[btree_internal::Count<true>(Keys(n), Hdr(n).count, k)];
+    }
+    return n;
+  }
+
+  // Inserts into the subtree at `n` of the given height. If `n` had to split,
+  // `*split` is the new right sibling and its separator.
+  std::pair<iterator, bool> Insert(Node* n, size_t height, K k, const V& v,
+                                   Split* split) {
+    Header& h = Hdr(n);
+    if (height == 0) {
+      size_t pos = btree_internal::Count<false>(Keys(n), h.count, k);
+      if (pos < h.count && Keys(n)[pos] == k) return {iterator(n, pos), false};
+      if (h.count == kLeafCapacity) {
+        // Appending (e.g. keys in increasing order): leave the node full.
+        *split = SplitLeaf(
+            n, pos == kLeafCapacity ? kLeafCapacity : kLeafCapacity / 2);
+        if (pos > Hdr(n).count || pos == kLeafCapacity) {
+          pos -= Hdr(n).count;
+          n = split->right;
+        }
+      }
+      Header& nh = Hdr(n);
+      memmove(Keys(n) + pos + 1, Keys(n) + pos, (nh.count - pos) * sizeof(K));
+      memmove(Values(n) + pos + 1, Values(n) + pos,
+              (nh.count - pos) * sizeof(V));
+      Keys(n)[pos] = k;
+      Values(n)[pos] = v;
+      ++nh.count;
+      if (split->right != nullptr) split->key = Keys(split->right)[0];
+      return {iterator(n, pos), true};
+    }
+
+    size_t i = btree_internal::Count<true>(Keys(n), h.count, k);
+    Split child;
+    const std::pair<iterator, bool> res =
+        Insert(Children(n)[i], height - 1, k, v, &child);
+    if (child.right == nullptr) return res;
+    if (h.count == kInnerCapacity) {
+      *split = SplitInner(n, i == kInnerCapacity ? kInnerCapacity - 1
+                                                 : kInnerCapacity / 2);
+      if (i > Hdr(n).count) {
+        i -= Hdr(n).count + 1;
+        n = split->right;
+      }
+    }
+    Header& nh = Hdr(n);
+    memmove(Keys(n) + i + 1, Keys(n) + i, (nh.count - i) * sizeof(K));
+    memmove(Children(n) + i + 2, Children(n) + i + 1,
+            (nh.count - i) * sizeof(Node*));
+    Keys(n)[i] = child.key;
+    Children(n)[i + 1] = child.right;
+    ++nh.count;
+    return res;
+  }
+
+  // Moves the elements after the first `keep` of a full leaf to a new leaf.
+  Split SplitLeaf(Node* n, size_t keep) {
+    Node* right = NewNode(true);
+    const size_t move = kLeafCapacity - keep;
+    memcpy(Keys(right), Keys(n) + keep, move * sizeof(K));
+    memcpy(Values(right), Values(n) + keep, move * sizeof(V));
+    Hdr(right).count = move;
+    Hdr(right).next = Hdr(n).next;
+    Hdr(n).count = keep;
+    Hdr(n).next = right;
+    return {Keys(right)[0], right};
+  }
+
+  // Moves the keys and children after key `keep` of a full internal node to a
+  // new node; key `keep` becomes the separator.
+  Split SplitInner(Node* n, size_t keep) {
+    Node* right = NewNode(false);
+    const size_t move = kInnerCapacity - keep - 1;
+    memcpy(Keys(right), Keys(n) + keep + 1, move * sizeof(K));
+    memcpy(Children(right), Children(n) + keep + 1,
+           (move + 1) * sizeof(Node*));
+    Hdr(right).count = move;
+    Hdr(n).count = keep;
+    return {Keys(n)[keep], right};
+  }
+
+  Node* root_ = nullptr;
+  Node* first_ = nullptr;  // leftmost leaf
+  size_t height_ = 0;
+  size_t size_ = 0;
+  size_t nodes_ = 0;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_BTREE_MAP_H_
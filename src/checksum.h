@@ -0,0 +1,313 @@
+// CRC32C integrity trailers for `Layout` blobs, and files that hold them.
+//
+// A checksummed blob is the blob followed by a trailer:
+//
+//   [ blob: AllocSize() bytes ][ field CRCs: uint32_t[n] ][ footer: 24 bytes ]
+//
+// The footer holds the blob size, the CRC32C of the whole blob, the number of
+// per-field CRCs (0 in `ChecksumMode::kBlob`) and a CRC of the trailer itself.
+// The trailer is unaligned and in host byte order, like the blob.
+//
+//   const L layout(n, m);
+//   unsigned char* p = (unsigned char*)aligned_alloc_posix(
+//       L::Alignment(), ChecksummedSize(layout, ChecksumMode::kPerField));
+//   ...fill the blob...
+//   size_t size = WriteChecksums(layout, p, ChecksumMode::kPerField, &pool);
+//   ...send p[0, size) over the network...
+//   if (!VerifyChecksums(q, size, &pool)) ...            // no layout needed
+//   int bad = FindCorruptField(layout, q, size);          // -1 if none
+//
+//   WriteLayoutFile("/data/x.blob", layout, p, ChecksumMode::kBlob);
+//   MappedLayoutFile f = MappedLayoutFile::Open("/data/x.blob", true, &pool);
+//   if (!f.valid()) ...                                    // missing or corrupt
+//   use(f.data());
+//
+// Checksums use `Crc32c()` (crc32c.h): SSE4.2 with three interleaved streams,
+// ~8 bytes per cycle per core. With a `ThreadPool`, fields and blobs of at
+// least 1 MiB are split across the workers and the partial CRCs combined, so
+// verifying a multi-GB file runs at memory bandwidth rather than at one core's
+// CRC rate. In `kPerField` mode the blob CRC is combined from the field CRCs
+// (and the CRCs of the padding between them), so the blob is read once.
+
+#ifndef ABSL_CONTAINER_INTERNAL_CHECKSUM_H_
+#define ABSL_CONTAINER_INTERNAL_CHECKSUM_H_
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+#include <vector>
+
+#include "crc32c.h"
+#include "layout.h"
+#include "thread_pool.h"
+
+namespace absl {
+namespace container_internal {
+
+enum class ChecksumMode {
+  kBlob,      // one CRC for the whole blob
+  kPerField,  // the blob CRC and one CRC per array
+};
+
+namespace checksum_internal {
+
+struct Footer {
+  uint64_t blob_size;
+  uint32_t blob_crc;
+  uint32_t num_fields;
+  uint32_t trailer_crc;  // of the field CRCs and the members above
+  uint32_t magic;
+};
+static_assert(sizeof(Footer) == 24);
+
+// "LCRC"
+inline constexpr uint32_t kMagic = 0x4352434c;
+
+inline uint32_t Crc(ThreadPool* pool, const unsigned char* p, size_t n,
+                    uint32_t crc = 0) {
+  return pool != nullptr ? Crc32cParallel(*pool, p, n, crc) : Crc32c(p, n, crc);
+}
+
+inline uint32_t TrailerCrc(const unsigned char* field_crcs, size_t num_fields,
+                           const Footer& f) {
+  const uint32_t crc = Crc32c(field_crcs, num_fields * sizeof(uint32_t));
+  return Crc32c(&f, offsetof(Footer, trailer_crc), crc);
+}
+
+// Parses the trailer at the end of `p[0, size)`. On success `*footer` is the
+// footer and `*field_crcs` points to its field CRCs (unaligned).
+inline bool ReadTrailer(const unsigned char* p, size_t size, Footer* footer,
+                        const unsigned char** field_crcs) {
+  if (size < sizeof(Footer)) return false;
+  memcpy(footer, p + size - sizeof(Footer), sizeof(Footer));
+  if (footer->magic != kMagic) return false;
+  const size_t trailer = sizeof(Footer) + size_t{footer->num_fields} * 4;
+  if (trailer > size || footer->blob_size != size - trailer) return false;
+  *field_crcs = p + footer->blob_size;
+  return footer->trailer_crc ==
+         TrailerCrc(*field_crcs, footer->num_fields, *footer);
+}
+
+inline uint32_t FieldCrc(const unsigned char* field_crcs, size_t i) {
+  uint32_t crc;
+  memcpy(&crc, field_crcs + i * sizeof(uint32_t), sizeof(crc));
+  return crc;
+}
+
+}  // namespace checksum_internal
+
+// Bytes of the trailer for a layout with `num_fields` arrays.
+inline constexpr size_t ChecksumTrailerSize(ChecksumMode mode,
+                                            size_t num_fields) {
+  return sizeof(checksum_internal::Footer) +
+         (mode == ChecksumMode::kPerField ? num_fields * sizeof(uint32_t) : 0);
+}
+
+// `AllocSize()` plus the trailer.
+template <class L>
+size_t ChecksummedSize(const L& layout, ChecksumMode mode) {
+  return layout.AllocSize() + ChecksumTrailerSize(mode, L::NumTypes);
+}
+
+// The trailer for the blob of `layout` at `p`.
+template <class L>
+std::vector<unsigned char> MakeChecksumTrailer(const L& layout,
+                                               const unsigned char* p,
+                                               ChecksumMode mode,
+                                               ThreadPool* pool = nullptr) {
+  namespace ci = checksum_internal;
+  const size_t num_fields = mode == ChecksumMode::kPerField ? L::NumTypes : 0;
+  std::vector<unsigned char> trailer(ChecksumTrailerSize(mode, L::NumTypes));
+  ci::Footer f{};
+  f.blob_size = layout.AllocSize();
+  f.num_fields = static_cast<uint32_t>(num_fields);
+  f.magic = ci::kMagic;
+  if (mode == ChecksumMode::kBlob) {
+    f.blob_crc = ci::Crc(pool, p, f.blob_size);
+  } else {
+    // Field CRCs, and the blob CRC stitched from them and from the padding.
+    uint32_t blob = 0;
+    size_t end = 0;
+    [&]<size_t... N>(std::index_sequence<N...>) {
+      ((void)[&] {
+        const size_t begin = layout.template Offset<N>();
+        const size_t bytes = layout.template ArrayBytes<N>();
+        blob = Crc32c(p + end, begin - end, blob);
+        const uint32_t crc = ci::Crc(pool, p + begin, bytes);
+        memcpy(trailer.data() + N * sizeof(uint32_t), &crc, sizeof(crc));
+        blob = Crc32cCombine(blob, crc, bytes);
+        end = begin + bytes;
+      }(), ...);
+    }(std::make_index_sequence<L::NumTypes>());
+    f.blob_crc = Crc32c(p + end, f.blob_size - end, blob);
+  }
+  f.trailer_crc = ci::TrailerCrc(trailer.data(), num_fields, f);
+  memcpy(trailer.data() + num_fields * sizeof(uint32_t), &f, sizeof(f));
+  return trailer;
+}
+
+// Writes the trailer right after the blob and returns the total size.
+//
+// Requires: `p` points to `ChecksummedSize(layout, mode)` bytes.
+template <class L>
+size_t WriteChecksums(const L& layout, unsigned char* p, ChecksumMode mode,
+                      ThreadPool* pool = nullptr) {
+  const std::vector<unsigned char> trailer =
+      MakeChecksumTrailer(layout, p, mode, pool);
+  memcpy(p + layout.AllocSize(), trailer.data(), trailer.size());
+  return layout.AllocSize() + trailer.size();
+}
+
+// Checks the trailer at the end of `p[0, size)` and the CRC of the whole blob
+// it covers. On success stores the blob size in `*blob_size` (if not null).
+inline bool VerifyChecksums(const unsigned char* p, size_t size,
+                            ThreadPool* pool = nullptr,
+                            size_t* blob_size = nullptr) {
+  namespace ci = checksum_internal;
+  ci::Footer f;
+  const unsigned char* field_crcs;
+  if (!ci::ReadTrailer(p, size, &f, &field_crcs)) return false;
+  if (ci::Crc(pool, p, f.blob_size) != f.blob_crc) return false;
+  if (blob_size != nullptr) *blob_size = f.blob_size;
+  return true;
+}
+
+// Index of the first array of `layout` whose CRC doesn't match, -1 if all
+// match. Returns `L::NumTypes` if the trailer is damaged, has no per-field
+// CRCs or doesn't describe a blob of `layout`.
+template <class L>
+int FindCorruptField(const L& layout, const unsigned char* p, size_t size,
+                     ThreadPool* pool = nullptr) {
+  namespace ci = checksum_internal;
+  ci::Footer f;
+  const unsigned char* field_crcs;
+  if (!ci::ReadTrailer(p, size, &f, &field_crcs) ||
+      f.num_fields != L::NumTypes || f.blob_size != layout.AllocSize()) {
+    return L::NumTypes;
+  }
+  int bad = -1;
+  [&]<size_t... N>(std::index_sequence<N...>) {
+    ((bad < 0 &&
+      ci::Crc(pool, p + layout.template Offset<N>(),
+              layout.template ArrayBytes<N>()) !=
+          ci::FieldCrc(field_crcs, N) &&
+      (bad = N, true)), ...);
+  }(std::make_index_sequence<L::NumTypes>());
+  return bad;
+}
+
+// Writes the blob of `layout` at `p` and its trailer to `path`, replacing the
+// file.
+template <class L>
+bool WriteLayoutFile(const char* path, const L& layout, const unsigned char* p,
+                     ChecksumMode mode, ThreadPool* pool = nullptr) {
+  const std::vector<unsigned char> trailer =
+      MakeChecksumTrailer(layout, p, mode, pool);
+  const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  const auto write_all = [fd](const unsigned char* b, size_t n) {
+    while (n != 0) {
+      const ssize_t r = write(fd, b, n);
+      if (r <= 0) return false;
+      b += r;
+      n -= r;
+    }
+    return true;
+  };
+  const bool ok = write_all(p, layout.AllocSize()) &&
+                  write_all(trailer.data(), trailer.size());
+  return close(fd) == 0 && ok;
+}
+
+// A read-only mapping of a file written by `WriteLayoutFile()`. The blob
+// starts at the beginning of the mapping, so it's page-aligned.
+class MappedLayoutFile {
+ public:
+  MappedLayoutFile() = default;
+
+  MappedLayoutFile(MappedLayoutFile&& other) noexcept
+      : base_(std::exchange(other.base_, nullptr)),
+        file_size_(std::exchange(other.file_size_, 0)),
+        blob_size_(std::exchange(other.blob_size_, 0)) {}
+
+  MappedLayoutFile& operator=(MappedLayoutFile&& other) noexcept {
+    if (this != &other) {
+      Release();
+      base_ = std::exchange(other.base_, nullptr);
+      file_size_ = std::exchange(other.file_size_, 0);
+      blob_size_ = std::exchange(other.blob_size_, 0);
+    }
+    return *this;
+  }
+
+  ~MappedLayoutFile() { Release(); }
+
+  // Maps `path`. The trailer is always checked; with `verify` the CRC of the
+  // whole blob is too, which reads the file once (on the workers of `pool`,
+  // if given). The result is invalid if the file can't be mapped or doesn't
+  // pass the checks.
+  static MappedLayoutFile Open(const char* path, bool verify,
+                               ThreadPool* pool = nullptr) {
+    namespace ci = checksum_internal;
+    MappedLayoutFile file;
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return file;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return file;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return file;
+    file.base_ = static_cast<unsigned char*>(p);
+    file.file_size_ = size;
+    if (verify) {
+      // The whole file is read once: ask for readahead.
+      madvise(p, size, MADV_SEQUENTIAL);
+      madvise(p, size, MADV_WILLNEED);
+      if (!VerifyChecksums(file.base_, size, pool, &file.blob_size_)) {
+        return MappedLayoutFile();
+      }
+    } else {
+      ci::Footer f;
+      const unsigned char* field_crcs;
+      if (!ci::ReadTrailer(file.base_, size, &f, &field_crcs)) {
+        return MappedLayoutFile();
+      }
+      file.blob_size_ = f.blob_size;
+    }
+    return file;
+  }
+
+  bool valid() const { return base_ != nullptr; }
+  const unsigned char* data() const { return base_; }
+  size_t blob_size() const { return blob_size_; }
+  // The blob and the trailer, for `FindCorruptField()`.
+  size_t file_size() const { return file_size_; }
+
+ private:
+  void Release() {
+    if (base_ != nullptr) munmap(base_, file_size_);
+    base_ = nullptr;
+    file_size_ = 0;
+    blob_size_ = 0;
+  }
+
+  unsigned char* base_ = nullptr;
+  size_t file_size_ = 0;
+  size_t blob_size_ = 0;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_CHECKSUM_H_
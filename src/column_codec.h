@@ -0,0 +1,695 @@
+// Compressed encoding of the arrays of a `Layout` block, for disk and network.
+//
+// A raw block (see test_serialize.cpp) stores every element at full width.
+// Integer and float columns are usually far from random: sorted ids and
+// timestamps, small counters, long runs of the same value, slowly changing
+// measurements. `EncodeColumns()` compresses every array of a block with the
+// codec that gives the smallest result for that array:
+//
+//   kRaw     the elements as they are
+//   kFor     frame of reference: `v - min`, bit-packed with the fewest bits
+//            that hold `max - min` (integers)
+//   kDelta   `v[i] - v[i - 1] - min_delta`, bit-packed (integers; sorted ids,
+//            timestamps)
+//   kRle     runs of bitwise equal elements as (length, value) pairs
+//   kXor     Gorilla-style: the XOR of every value with the previous one,
+//            stored as its meaningful bits only (float, double)
+//
+// Decoding writes straight into the arrays of a block with the same layout:
+//
+//   std::vector<unsigned char> enc = EncodeColumns(layout, p);
+//   ... write `enc` to a file, read it back ...
+//   EncodedColumns cols(enc.data(), enc.size());
+//   if (!cols.valid()) ...
+//   const MyCompactFoo::L layout2 = cols.MakeLayout<MyCompactFoo::L>();
+//   unsigned char* q = (unsigned char*)aligned_alloc_posix(
+//       MyCompactFoo::L::Alignment(), layout2.AllocSize());
+//   cols.DecodeAll(layout2, q);        // or cols.Decode<N>(layout2, q)
+//
+// Bit-packed values are unpacked four at a time with AVX2 (gather, variable
+// shift, mask, add) when the CPU has it, decoding at several GB/s of output;
+// that is well above what an SSD delivers, so reading the encoded bytes and
+// decoding them is faster than reading the raw bytes. RLE decodes with
+// `std::fill`. The XOR codec is a serial bit stream by construction and is
+// only chosen when it's the smallest.
+//
+// Format (host byte order, little-endian in practice; no alignment is
+// required, everything is read with `memcpy` or unaligned loads):
+//
+//   EncodedHeader                     magic, number of arrays
+//   ColumnHeader[num_columns]         codec, element size, count, payload
+//   payloads, each followed by 8 zero bytes so that decoders can always load
+//   a whole 64-bit word
+
+#ifndef ABSL_CONTAINER_INTERNAL_COLUMN_CODEC_H_
+#define ABSL_CONTAINER_INTERNAL_COLUMN_CODEC_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+enum class Codec : uint8_t { kRaw, kFor, kDelta, kRle, kXor };
+
+inline const char* CodecName(Codec c) {
+  switch (c) {
+    case Codec::kRaw: return "raw";
+    case Codec::kFor: return "for";
+    case Codec::kDelta: return "delta";
+    case Codec::kRle: return "rle";
+    case Codec::kXor: return "xor";
+  }
+  return "?";
+}
+
+struct EncodedHeader {
+  uint32_t magic;
+  uint32_t num_columns;
+};
+
+struct ColumnHeader {
+  uint8_t codec;
+  uint8_t elem_size;
+  uint8_t bit_width;   // kFor, kDelta
+  uint8_t value_bits;  // K for a `Bits<K>` array, whose words are encoded
+  uint8_t reserved[4];
+  uint64_t count;      // number of elements (values for `Bits<K>`)
+  uint64_t offset;     // of the payload, from the start of the encoding
+  uint64_t bytes;      // of the payload, without the 8 bytes of padding
+  uint64_t base;       // kFor: min; kDelta, kXor: first element
+  uint64_t aux;        // kDelta: min delta; kRle: number of runs
+};
+
+namespace column_codec_internal {
+
+inline constexpr uint32_t kMagic = 0x4c4f4343;  // "CCOL"
+inline constexpr size_t kPad = 8;
+// Bit-packed values are read with one unaligned 64-bit load, which covers any
+// width up to 64 - 7.
+inline constexpr unsigned kMaxBitWidth = 56;
+// Values unpacked into a scratch buffer per step by kDelta and narrow kFor.
+inline constexpr size_t kBlock = 256;
+
+// Number of elements the codec sees: `count`, or the number of words of a
+// `Bits<K>` array.
+inline uint64_t Elements(const ColumnHeader& h) {
+  return h.value_bits == 0 ? h.count : (h.count * h.value_bits + 63) / 64;
+}
+
+inline unsigned BitWidth(uint64_t x) {
+  return x == 0 ? 0 : 64 - __builtin_clzll(x);
+}
+
+inline uint64_t Load64(const unsigned char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+template <class T>
+uint64_t ToBits(T v) {
+  if constexpr (std::is_integral_v<T>) {
+    return static_cast<uint64_t>(v);
+  } else {
+    std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t> u;
+    memcpy(&u, &v, sizeof(T));
+    return u;
+  }
+}
+
+template <class T>
+T FromBits(uint64_t bits) {
+  if constexpr (std::is_integral_v<T>) {
+    return static_cast<T>(bits);
+  } else {
+    std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t> u =
+        static_cast<decltype(u)>(bits);
+    T v;
+    memcpy(&v, &u, sizeof(T));
+    return v;
+  }
+}
+
+// LSB-first bit stream: value `i` of width `w` starts at bit `i * w`.
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<unsigned char>* out) : out_(out) {}
+
+  void Put(uint64_t v, unsigned width) {
+    if (width < 64) v &= (uint64_t{1} << width) - 1;
+    while (width > 32) {
+      Put32(v & 0xffffffff, 32);
+      v >>= 32;
+      width -= 32;
+    }
+    Put32(v, width);
+  }
+
+  void Flush() {
+    if (fill_ != 0) out_->push_back(static_cast<unsigned char>(acc_));
+    acc_ = 0;
+    fill_ = 0;
+  }
+
+ private:
+  void Put32(uint64_t v, unsigned width) {
+    acc_ |= v << fill_;
+    fill_ += width;
+    while (fill_ >= 8) {
+      out_->push_back(static_cast<unsigned char>(acc_));
+      acc_ >>= 8;
+      fill_ -= 8;
+    }
+  }
+
+  std::vector<unsigned char>* out_;
+  uint64_t acc_ = 0;
+  unsigned fill_ = 0;
+};
+
+// Reads a stream of `bytes` bytes. Reading past the end yields zeros and sets
+// `overrun()`.
+//
+// Requires: 8 readable bytes past the last byte of the stream.
+class BitReader {
+ public:
+  BitReader(const unsigned char* p, size_t bytes) : p_(p), bytes_(bytes) {}
+
+  bool overrun() const { return overrun_; }
+
+  uint64_t Get(unsigned width) {
+    if (width <= 32) return Get32(width);
+    uint64_t lo = Get32(32);
+    return lo | Get32(width - 32) << 32;
+  }
+
+ private:
+  uint64_t Get32(unsigned width) {
+    if (width == 0) return 0;
+    if ((pos_ >> 3) >= bytes_) {
+      overrun_ = true;
+      return 0;
+    }
+    uint64_t v = Load64(p_ + (pos_ >> 3)) >> (pos_ & 7);
+    pos_ += width;
+    return v & ((uint64_t{1} << width) - 1);
+  }
+
+  const unsigned char* p_;
+  const size_t bytes_;
+  uint64_t pos_ = 0;
+  bool overrun_ = false;
+};
+
+// out[j] = base + (value `begin + j` of width `w`) for j in [0, end - begin).
+inline void UnpackScalar(const unsigned char* in, unsigned w, uint64_t base,
+                         size_t begin, size_t end, uint64_t* out) {
+  const uint64_t mask = w == 0 ? 0 : (uint64_t{1} << w) - 1;
+  uint64_t bit = begin * w;
+  for (size_t i = begin; i != end; ++i, bit += w) {
+    *out++ = base + ((Load64(in + (bit >> 3)) >> (bit & 7)) & mask);
+  }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) inline void UnpackAvx2(
+    const unsigned char* in, unsigned w, uint64_t base, size_t begin,
+    size_t end, uint64_t* out) {
+  const uint64_t m = w == 0 ? 0 : (uint64_t{1} << w) - 1;
+  const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(m));
+  const __m256i vbase = _mm256_set1_epi64x(static_cast<long long>(base));
+  const __m256i seven = _mm256_set1_epi64x(7);
+  const __m256i step = _mm256_set1_epi64x(static_cast<long long>(4 * w));
+  const long long b0 = static_cast<long long>(begin * w);
+  __m256i bits = _mm256_set_epi64x(b0 + 3 * w, b0 + 2 * w, b0 + w, b0);
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4, out += 4) {
+    __m256i words = _mm256_i64gather_epi64(
+        reinterpret_cast<const long long*>(in), _mm256_srli_epi64(bits, 3), 1);
+    words = _mm256_srlv_epi64(words, _mm256_and_si256(bits, seven));
+    words = _mm256_add_epi64(_mm256_and_si256(words, mask), vbase);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), words);
+    bits = _mm256_add_epi64(bits, step);
+  }
+  UnpackScalar(in, w, base, i, end, out);
+}
+
+inline bool HasAvx2() {
+  static const bool kHas = __builtin_cpu_supports("avx2");
+  return kHas;
+}
+#endif
+
+inline void Unpack(const unsigned char* in, unsigned w, uint64_t base,
+                   size_t begin, size_t end, uint64_t* out) {
+#if defined(__x86_64__)
+  if (HasAvx2()) return UnpackAvx2(in, w, base, begin, end, out);
+#endif
+  UnpackScalar(in, w, base, begin, end, out);
+}
+
+// An encoded column before it's appended to the output.
+struct Candidate {
+  ColumnHeader header{};
+  std::vector<unsigned char> payload;
+};
+
+template <class T>
+void EncodeRaw(const T* v, size_t n, Candidate* c) {
+  c->header.codec = static_cast<uint8_t>(Codec::kRaw);
+  c->payload.resize(n * sizeof(T));
+  if (n != 0) memcpy(c->payload.data(), v, n * sizeof(T));
+}
+
+template <class T>
+bool EncodeFor(const T* v, size_t n, Candidate* c) {
+  if (n == 0) return false;
+  auto [lo, hi] = std::minmax_element(v, v + n);
+  const uint64_t base = ToBits(*lo);
+  const unsigned w = BitWidth(ToBits(*hi) - base);
+  if (w > kMaxBitWidth) return false;
+  c->header.codec = static_cast<uint8_t>(Codec::kFor);
+  c->header.bit_width = static_cast<uint8_t>(w);
+  c->header.base = base;
+  BitWriter out(&c->payload);
+  for (size_t i = 0; i != n; ++i) out.Put(ToBits(v[i]) - base, w);
+  out.Flush();
+  return true;
+}
+
+template <class T>
+bool EncodeDelta(const T* v, size_t n, Candidate* c) {
+  if (n < 2) return false;
+  int64_t lo = INT64_MAX, hi = INT64_MIN;
+  for (size_t i = 1; i != n; ++i) {
+    const int64_t d = static_cast<int64_t>(ToBits(v[i]) - ToBits(v[i - 1]));
+    lo = std::min(lo, d);
+    hi = std::max(hi, d);
+  }
+  const uint64_t min_delta = static_cast<uint64_t>(lo);
+  const unsigned w = BitWidth(static_cast<uint64_t>(hi) - min_delta);
+  if (w > kMaxBitWidth) return false;
+  c->header.codec = static_cast<uint8_t>(Codec::kDelta);
+  c->header.bit_width = static_cast<uint8_t>(w);
+  c->header.base = ToBits(v[0]);
+  c->header.aux = min_delta;
+  BitWriter out(&c->payload);
+  for (size_t i = 1; i != n; ++i) {
+    out.Put(ToBits(v[i]) - ToBits(v[i - 1]) - min_delta, w);
+  }
+  out.Flush();
+  return true;
+}
+
+// Payload: uint32_t lengths[runs], padded to 8 bytes, then T values[runs].
+template <class T>
+bool EncodeRle(const T* v, size_t n, Candidate* c) {
+  if (n == 0) return false;
+  std::vector<uint32_t> lengths;
+  std::vector<T> values;
+  for (size_t i = 0; i != n;) {
+    size_t j = i + 1;
+    while (j != n && j - i != UINT32_MAX &&
+           memcmp(&v[j], &v[i], sizeof(T)) == 0) {
+      ++j;
+    }
+    lengths.push_back(static_cast<uint32_t>(j - i));
+    values.push_back(v[i]);
+    i = j;
+  }
+  const size_t runs = lengths.size();
+  const size_t values_at = (runs * sizeof(uint32_t) + 7) & ~size_t{7};
+  c->header.codec = static_cast<uint8_t>(Codec::kRle);
+  c->header.aux = runs;
+  c->payload.assign(values_at + runs * sizeof(T), 0);
+  memcpy(c->payload.data(), lengths.data(), runs * sizeof(uint32_t));
+  memcpy(c->payload.data() + values_at, values.data(), runs * sizeof(T));
+  return true;
+}
+
+// Per value after the first, with `x = bits ^ prev_bits`:
+//   0                                   x == 0
+//   1 0  <bits>                         the meaningful bits of `x` fit in the
+//                                       previous leading/trailing-zero window
+//   1 1  <5: leading> <6: length % 64> <length bits>
+template <class T>
+bool EncodeXor(const T* v, size_t n, Candidate* c) {
+  if (n == 0) return false;
+  constexpr unsigned kBits = sizeof(T) * 8;
+  c->header.codec = static_cast<uint8_t>(Codec::kXor);
+  c->header.base = ToBits(v[0]);
+  BitWriter out(&c->payload);
+  uint64_t prev = ToBits(v[0]);
+  unsigned prev_lead = kBits + 1, prev_trail = 0;  // no window yet
+  for (size_t i = 1; i != n; ++i) {
+    const uint64_t cur = ToBits(v[i]);
+    const uint64_t x = cur ^ prev;
+    prev = cur;
+    if (x == 0) {
+      out.Put(0, 1);
+      continue;
+    }
+    unsigned lead = __builtin_clzll(x) - (64 - kBits);
+    if (lead > 31) lead = 31;
+    const unsigned trail = __builtin_ctzll(x);
+    if (prev_lead <= kBits && lead >= prev_lead && trail >= prev_trail) {
+      out.Put(1, 2);
+      out.Put(x >> prev_trail, kBits - prev_lead - prev_trail);
+    } else {
+      const unsigned len = kBits - lead - trail;
+      out.Put(3, 2);
+      out.Put(lead, 5);
+      out.Put(len & 63, 6);
+      out.Put(x >> trail, len);
+      prev_lead = lead;
+      prev_trail = trail;
+    }
+  }
+  out.Flush();
+  return true;
+}
+
+template <class T>
+void DecodeFor(const ColumnHeader& h, const unsigned char* in, T* dst) {
+  const size_t n = h.count;
+  if constexpr (std::is_same_v<std::make_unsigned_t<T>, uint64_t>) {
+    Unpack(in, h.bit_width, h.base, 0, n, reinterpret_cast<uint64_t*>(dst));
+  } else {
+    uint64_t scratch[kBlock];
+    for (size_t i = 0; i < n; i += kBlock) {
+      const size_t end = std::min(n, i + kBlock);
+      Unpack(in, h.bit_width, h.base, i, end, scratch);
+      for (size_t j = i; j != end; ++j) dst[j] = static_cast<T>(scratch[j - i]);
+    }
+  }
+}
+
+template <class T>
+void DecodeDelta(const ColumnHeader& h, const unsigned char* in, T* dst) {
+  const size_t n = h.count;
+  uint64_t prev = h.base;
+  dst[0] = static_cast<T>(prev);
+  uint64_t scratch[kBlock];
+  for (size_t i = 0; i + 1 < n; i += kBlock) {
+    const size_t end = std::min(n - 1, i + kBlock);
+    Unpack(in, h.bit_width, h.aux, i, end, scratch);
+    for (size_t j = i; j != end; ++j) {
+      prev += scratch[j - i];
+      dst[j + 1] = static_cast<T>(prev);
+    }
+  }
+}
+
+template <class T>
+void DecodeRle(const ColumnHeader& h, const unsigned char* in, T* dst) {
+  const size_t runs = h.aux;
+  const unsigned char* values = in + ((runs * sizeof(uint32_t) + 7) & ~size_t{7});
+  for (size_t r = 0; r != runs; ++r) {
+    uint32_t len;
+    T value;
+    memcpy(&len, in + r * sizeof(uint32_t), sizeof(len));
+    memcpy(&value, values + r * sizeof(T), sizeof(T));
+    std::fill(dst, dst + len, value);
+    dst += len;
+  }
+}
+
+// Returns false if the stream is malformed.
+template <class T>
+bool DecodeXor(const ColumnHeader& h, const unsigned char* in, T* dst) {
+  constexpr unsigned kBits = sizeof(T) * 8;
+  BitReader bits(in, h.bytes);
+  uint64_t prev = h.base;
+  unsigned lead = 0, trail = 0;
+  dst[0] = FromBits<T>(prev);
+  for (size_t i = 1; i != h.count; ++i) {
+    if (bits.Get(1) != 0) {
+      if (bits.Get(1) != 0) {
+        lead = static_cast<unsigned>(bits.Get(5));
+        unsigned len = static_cast<unsigned>(bits.Get(6));
+        if (len == 0) len = 64;
+        if (lead + len > kBits) return false;
+        trail = kBits - lead - len;
+      }
+      prev ^= bits.Get(kBits - lead - trail) << trail;
+    }
+    dst[i] = FromBits<T>(prev);
+  }
+  return !bits.overrun();
+}
+
+// Counts the elements a kRle payload expands to; the decoder trusts it.
+inline uint64_t RleCount(const ColumnHeader& h, const unsigned char* in) {
+  uint64_t total = 0;
+  for (size_t r = 0; r != h.aux; ++r) {
+    uint32_t len;
+    memcpy(&len, in + r * sizeof(uint32_t), sizeof(len));
+    total += len;
+  }
+  return total;
+}
+
+template <class T>
+constexpr bool kIsBitPackable =
+    std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+template <class T>
+constexpr bool kIsWord = sizeof(T) == 1 || sizeof(T) == 2 ||
+                         sizeof(T) == 4 || sizeof(T) == 8;
+
+template <class T>
+Candidate EncodeColumn(const T* v, size_t n) {
+  Candidate best;
+  EncodeRaw(v, n, &best);
+  auto consider = [&](auto encode) {
+    Candidate c;
+    if (encode(v, n, &c) && c.payload.size() < best.payload.size()) {
+      best = std::move(c);
+    }
+  };
+  if constexpr (kIsBitPackable<T>) {
+    consider(EncodeFor<T>);
+    consider(EncodeDelta<T>);
+  }
+  if constexpr (std::is_trivially_copyable_v<T> && kIsWord<T>) {
+    consider(EncodeRle<T>);
+  }
+  if constexpr (std::is_floating_point_v<T> && kIsWord<T>) {
+    consider(EncodeXor<T>);
+  }
+  best.header.elem_size = static_cast<uint8_t>(sizeof(T));
+  best.header.count = n;
+  best.header.bytes = best.payload.size();
+  return best;
+}
+
+}  // namespace column_codec_internal
+
+// Encodes all arrays of the block `p` laid out by `layout`, every array with
+// its smallest codec.
+template <class L>
+std::vector<unsigned char> EncodeColumns(const L& layout,
+                                         const unsigned char* p) {
+  namespace ci = column_codec_internal;
+  constexpr size_t kNum = std::tuple_size_v<typename L::ElementTypes>;
+  std::vector<ci::Candidate> cols;
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    // `Bits<K>` arrays are encoded as their words.
+    (cols.push_back(ci::EncodeColumn(
+         layout.template Pointer<I>(p),
+         layout.template ArrayBytes<I>() /
+             sizeof(typename L::template ElementType<I>))),
+     ...);
+    ((cols[I].header.count = layout.template Size<I>(),
+      cols[I].header.value_bits = static_cast<uint8_t>(
+          internal_layout::BitsPerValue<
+              typename L::template ElementSpec<I>>::value)),
+     ...);
+  }(std::make_index_sequence<kNum>());
+
+  size_t size = sizeof(EncodedHeader) + kNum * sizeof(ColumnHeader);
+  for (auto& c : cols) {
+    c.header.offset = size;
+    size += c.payload.size() + ci::kPad;
+  }
+  std::vector<unsigned char> out(size, 0);
+  const EncodedHeader header{ci::kMagic, static_cast<uint32_t>(kNum)};
+  memcpy(out.data(), &header, sizeof(header));
+  for (size_t i = 0; i != kNum; ++i) {
+    memcpy(out.data() + sizeof(EncodedHeader) + i * sizeof(ColumnHeader),
+           &cols[i].header, sizeof(ColumnHeader));
+    if (!cols[i].payload.empty()) {
+      memcpy(out.data() + cols[i].header.offset, cols[i].payload.data(),
+             cols[i].payload.size());
+    }
+  }
+  return out;
+}
+
+// A read-only view of the output of `EncodeColumns()`.
+class EncodedColumns {
+ public:
+  EncodedColumns(const unsigned char* data, size_t size)
+      : data_(data), size_(size) {
+    valid_ = Validate();
+  }
+
+  // False if the bytes are not a well-formed encoding.
+  bool valid() const { return valid_; }
+
+  size_t num_columns() const { return num_columns_; }
+  size_t count(size_t i) const { return Header(i).count; }
+  Codec codec(size_t i) const { return static_cast<Codec>(Header(i).codec); }
+  // Bytes of the payload of array `i` (without headers and padding).
+  size_t encoded_bytes(size_t i) const { return Header(i).bytes; }
+
+  // The layout of the encoded block.
+  //
+  // Requires: `valid()` and `L` has `num_columns()` arrays.
+  template <class L>
+  L MakeLayout() const {
+    constexpr size_t kNum = std::tuple_size_v<typename L::ElementTypes>;
+    assert(valid_ && num_columns_ == kNum);
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+      return L(count(I)...);
+    }(std::make_index_sequence<kNum>());
+  }
+
+  // Decodes array `N` into `layout.Slice<N>(p)`. Returns false if the
+  // encoding doesn't match the layout (element size or count).
+  template <size_t N, class L>
+  bool Decode(const L& layout, unsigned char* p) const {
+    namespace ci = column_codec_internal;
+    using T = typename L::template ElementType<N>;
+    if (!valid_ || N >= num_columns_) return false;
+    ColumnHeader h = Header(N);
+    auto slice = layout.template Slice<N>(p);
+    if (h.elem_size != sizeof(T) || h.count != slice.size()) return false;
+    if (h.value_bits != internal_layout::BitsPerValue<
+                            typename L::template ElementSpec<N>>::value) {
+      return false;
+    }
+    // From here on `count` is what the codec works with (words for Bits<K>).
+    h.count = ci::Elements(h);
+    if (h.count == 0) return true;
+    T* dst = slice.data();
+    const unsigned char* in = data_ + h.offset;
+    switch (static_cast<Codec>(h.codec)) {
+      case Codec::kRaw:
+        if (h.bytes != h.count * sizeof(T)) return false;
+        memcpy(static_cast<void*>(dst), in, h.bytes);
+        return true;
+      case Codec::kFor:
+        if constexpr (ci::kIsBitPackable<T>) {
+          ci::DecodeFor(h, in, dst);
+          return true;
+        }
+        return false;
+      case Codec::kDelta:
+        if constexpr (ci::kIsBitPackable<T>) {
+          ci::DecodeDelta(h, in, dst);
+          return true;
+        }
+        return false;
+      case Codec::kRle:
+        if constexpr (std::is_trivially_copyable_v<T> && ci::kIsWord<T>) {
+          // `Validate()` checked that the runs fit in the payload.
+          if (ci::RleCount(h, in) != h.count) return false;
+          ci::DecodeRle(h, in, dst);
+          return true;
+        }
+        return false;
+      case Codec::kXor:
+        if constexpr (std::is_floating_point_v<T> && ci::kIsWord<T>) {
+          return ci::DecodeXor(h, in, dst);
+        }
+        return false;
+    }
+    return false;
+  }
+
+  // Decodes all arrays. Returns false if any of them fails.
+  template <class L>
+  bool DecodeAll(const L& layout, unsigned char* p) const {
+    constexpr size_t kNum = std::tuple_size_v<typename L::ElementTypes>;
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+      return (Decode<I>(layout, p) && ...);
+    }(std::make_index_sequence<kNum>());
+  }
+
+ private:
+  ColumnHeader Header(size_t i) const {
+    assert(i < num_columns_);
+    ColumnHeader h;
+    memcpy(&h, data_ + sizeof(EncodedHeader) + i * sizeof(ColumnHeader),
+           sizeof(h));
+    return h;
+  }
+
+  // Checks the magic and that every payload (plus padding) is in bounds.
+  // Bit-packed payloads must hold `count` values of `bit_width` bits, and
+  // kRle payloads their `aux` runs.
+  bool Validate() {
+    namespace ci = column_codec_internal;
+    if (size_ < sizeof(EncodedHeader)) return false;
+    EncodedHeader header;
+    memcpy(&header, data_, sizeof(header));
+    if (header.magic != ci::kMagic) return false;
+    if (header.num_columns > (size_ - sizeof(EncodedHeader)) /
+                                 sizeof(ColumnHeader)) {
+      return false;
+    }
+    num_columns_ = header.num_columns;
+    for (size_t i = 0; i != num_columns_; ++i) {
+      ColumnHeader h = Header(i);
+      h.count = ci::Elements(h);
+      if (h.offset > size_ || h.bytes > size_ - h.offset ||
+          size_ - h.offset - h.bytes < ci::kPad) {
+        return false;
+      }
+      if (h.codec > static_cast<uint8_t>(Codec::kXor)) return false;
+      const Codec c = static_cast<Codec>(h.codec);
+      if (c == Codec::kFor || c == Codec::kDelta) {
+        if (h.bit_width > ci::kMaxBitWidth) return false;
+        const uint64_t values = c == Codec::kFor ? h.count : h.count - 1;
+        if (h.count != 0 && h.bit_width != 0 &&
+            values > h.bytes * 8 / h.bit_width) {
+          return false;
+        }
+      }
+      if (c == Codec::kRle) {
+        // The lengths, padded to 8 bytes, then the values. Dividing first
+        // keeps a forged run count from wrapping the product.
+        if (h.aux > h.bytes / (sizeof(uint32_t) + h.elem_size)) return false;
+        const uint64_t lengths = (h.aux * sizeof(uint32_t) + 7) & ~uint64_t{7};
+        if (lengths + h.aux * h.elem_size > h.bytes) return false;
+      }
+    }
+    return true;
+  }
+
+  const unsigned char* data_;
+  size_t size_;
+  size_t num_columns_ = 0;
+  bool valid_ = false;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_COLUMN_CODEC_H_
@@ -0,0 +1,316 @@
+// Epoch-based reclamation for blobs replaced while readers still use them.
+//
+//   EpochDomain domain;
+//   EpochPtr<unsigned char> table;                  // the current blob
+//
+//   // Readers, any number of threads:
+//   {
+//     EpochDomain::ReadGuard guard = domain.Read();
+//     const unsigned char* p = table.load();        // valid until `guard` ends
+//     ...
+//   }
+//
+//   // Writers:
+//   unsigned char* fresh = BuildTable();
+//   table.Publish(domain, fresh, [](unsigned char* old) {
+//     ::operator delete(old, std::align_val_t{L::Alignment()});  // or a pool
+//   });
+//
+// Every thread that reads owns a cache-line-sized slot in the domain. Entering
+// a read section copies the global epoch into the slot, and leaving it stores
+// 0. Both are plain loads and stores, with no read-modify-write and no fence.
+// The ordering that readers skip is supplied by the writer: after advancing
+// the epoch, `Collect()` calls `membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED)`,
+// which runs a full barrier on every CPU currently running one of our threads.
+// After that, each slot shows either the epoch its reader started in or 0.
+// A blob retired in epoch `e` is reclaimed once every active slot holds an
+// epoch greater than `e`. Where membarrier isn't available, readers issue a
+// seq_cst fence instead (like liburcu's fallback).
+//
+// Retired blobs are handed back through the caller's `reclaim` function: to
+// `operator delete`, to a free list, and so on. `Arena` blocks are never
+// freed one by one, so blobs from an arena should be retired with a no-op
+// reclaim function. `Retire()` runs `Collect()` itself every
+// `kCollectThreshold` blobs, so pending garbage stays bounded while at least
+// one reader keeps moving.
+//
+// Read sections nest. A thread must not wait for reclamation (`Synchronize()`)
+// inside its own read section. Each thread caches its slot for one domain at
+// a time. A thread that alternates between domains still works, but it looks
+// its slot up under the domain's mutex on every switch.
+
+#ifndef ABSL_CONTAINER_INTERNAL_EPOCH_H_
+#define ABSL_CONTAINER_INTERNAL_EPOCH_H_
+
+#include <linux/membarrier.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+namespace epoch_internal {
+
+// Registers the process for expedited private membarriers, once. False if
+// the kernel doesn't support them.
+inline bool MembarrierAvailable() {
+  static const bool available = [] {
+    const long cmds = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+    return cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0 &&
+           syscall(__NR_membarrier,
+                   MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+  }();
+  return available;
+}
+
+}  // namespace epoch_internal
+
+class EpochDomain {
+  struct alignas(internal_layout::kCacheLineSize) Slot {
+    // The epoch the owner's read section started in; 0 outside sections.
+    std::atomic<uint64_t> epoch{0};
+    // Touched only by the owner.
+    uint32_t nesting = 0;
+    std::thread::id owner;
+  };
+
+ public:
+  static constexpr size_t kCollectThreshold = 64;
+
+  EpochDomain()
+      : id_(NextId()), membarrier_(epoch_internal::MembarrierAvailable()) {}
+
+  // Reclaims everything still pending. Requires: no thread is in a read
+  // section of this domain.
+  ~EpochDomain() {
+    for (const Retired& r : retired_) r.Reclaim();
+  }
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  class ReadGuard {
+   public:
+    ReadGuard(ReadGuard&& other) noexcept
+        : domain_(std::exchange(other.domain_, nullptr)),
+          slot_(other.slot_) {}
+    ReadGuard& operator=(ReadGuard&&) = delete;
+    ~ReadGuard() {
+      if (domain_ != nullptr) domain_->Exit(slot_);
+    }
+
+   private:
+    friend class EpochDomain;
+    ReadGuard(EpochDomain* domain, Slot* slot)
+        : domain_(domain), slot_(slot) {}
+    EpochDomain* domain_;
+    Slot* slot_;
+  };
+
+  // Enters a read section that lasts as long as the guard: blobs loaded from
+  // an `EpochPtr` published through this domain stay valid until it ends.
+  [[nodiscard]] ReadGuard Read() {
+    Slot* slot = LocalSlot();
+    if (slot->nesting++ == 0) {
+      // Acquire: a reader that sees epoch `e + 1` also sees the pointers
+      // swapped before the writer advanced past `e`.
+      slot->epoch.store(epoch_.load(std::memory_order_acquire),
+                        std::memory_order_relaxed);
+      LightFence();
+    }
+    return ReadGuard(this, slot);
+  }
+
+  // Hands `p` to `reclaim(p)` once no read section that could have loaded it
+  // is still running. `p` must already be unreachable for new readers.
+  template <class T>
+  void Retire(T* p, std::type_identity_t<void (*)(T*)> reclaim) {
+    // The function pointer is stored type-erased and cast back to its own
+    // type before the call.
+    constexpr auto invoke = +[](void (*fn)(), void* q) {
+      reinterpret_cast<void (*)(T*)>(fn)(static_cast<T*>(q));
+    };
+    size_t pending;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      retired_.push_back(Retired{const_cast<void*>(static_cast<const void*>(p)),
+                                 reinterpret_cast<void (*)()>(reclaim), invoke,
+                                 epoch_.load(std::memory_order_relaxed)});
+      pending = retired_.size();
+    }
+    if (pending >= kCollectThreshold) Collect();
+  }
+
+  // Advances the epoch and reclaims the blobs no reader can hold any more.
+  // Returns how many were reclaimed.
+  size_t Collect() {
+    std::vector<Retired> ready;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      epoch_.fetch_add(1, std::memory_order_acq_rel);
+      HeavyFence();
+      uint64_t oldest = UINT64_MAX;
+      for (const auto& slot : slots_) {
+        const uint64_t e = slot->epoch.load(std::memory_order_acquire);
+        if (e != 0 && e < oldest) oldest = e;
+      }
+      auto keep = retired_.begin();
+      for (Retired& r : retired_) {
+        if (r.epoch < oldest) {
+          ready.push_back(r);
+        } else {
+          *keep++ = r;
+        }
+      }
+      retired_.erase(keep, retired_.end());
+    }
+    for (const Retired& r : ready) r.Reclaim();
+    return ready.size();
+  }
+
+  // Blocks until everything retired before the call has been reclaimed.
+  void Synchronize() {
+    const uint64_t target = epoch_.load(std::memory_order_relaxed);
+    for (;;) {
+      Collect();
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        bool done = true;
+        for (const Retired& r : retired_) done &= r.epoch > target;
+        if (done) return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // Retired blobs not reclaimed yet.
+  size_t pending() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return retired_.size();
+  }
+
+  bool uses_membarrier() const { return membarrier_; }
+
+ private:
+  struct Retired {
+    void* p;
+    void (*reclaim)();
+    void (*invoke)(void (*reclaim)(), void* p);
+    uint64_t epoch;
+
+    void Reclaim() const { invoke(reclaim, p); }
+  };
+
+  struct Cache {
+    uint64_t id = 0;
+    Slot* slot = nullptr;
+  };
+
+  static Cache& LocalCache() {
+    thread_local Cache cache;
+    return cache;
+  }
+
+  // Domain ids are never reused (see `Arena`).
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Slot* LocalSlot() {
+    Cache& c = LocalCache();
+    if (c.id != id_) {
+      c.slot = FindOrAddSlot();
+      c.id = id_;
+    }
+    return c.slot;
+  }
+
+  Slot* FindOrAddSlot() {
+    const std::thread::id self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto& slot : slots_) {
+      if (slot->owner == self) return slot.get();
+    }
+    slots_.push_back(std::make_unique<Slot>());
+    slots_.back()->owner = self;
+    return slots_.back().get();
+  }
+
+  void Exit(Slot* slot) {
+    if (--slot->nesting == 0) {
+      // Release: the section's reads finish before the slot reads as idle.
+      LightFence();
+      slot->epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  // The reader's side of the asymmetric fence: a compiler barrier when the
+  // writer uses membarrier, a real fence otherwise.
+  void LightFence() const {
+    if (membarrier_) {
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  void HeavyFence() const {
+    if (membarrier_) {
+      syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+    } else {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  const uint64_t id_;
+  const bool membarrier_;
+  // 0 marks an idle slot, so epochs start at 1.
+  alignas(internal_layout::kCacheLineSize) std::atomic<uint64_t> epoch_{1};
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<Retired> retired_;
+};
+
+// An atomically replaceable pointer to an immutable blob, read under an
+// `EpochDomain::ReadGuard`.
+template <class T>
+class EpochPtr {
+ public:
+  EpochPtr() = default;
+  explicit EpochPtr(T* p) : p_(p) {}
+
+  EpochPtr(const EpochPtr&) = delete;
+  EpochPtr& operator=(const EpochPtr&) = delete;
+
+  // Requires: a read section of the domain the pointer is published through,
+  // unless the caller is the only writer.
+  T* load() const { return p_.load(std::memory_order_acquire); }
+
+  // Makes `p` the current blob and retires the previous one (if any) to
+  // `reclaim`.
+  void Publish(EpochDomain& domain, T* p, void (*reclaim)(T*)) {
+    T* old = p_.exchange(p, std::memory_order_acq_rel);
+    if (old != nullptr) domain.Retire(old, reclaim);
+  }
+
+ private:
+  std::atomic<T*> p_{nullptr};
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_EPOCH_H_
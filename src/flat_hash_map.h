@@ -0,0 +1,505 @@
+// An open-addressing hash map in the style of Abseil's `raw_hash_set`, whose
+// control bytes and slots live in one `Layout` block.
+//
+//   FlatHashMap<uint64_t, double> m;
+//   m[42] = 1.5;
+//   m.insert(7, 2.0);
+//   if (auto it = m.find(42); it != m.end()) use(it->second);
+//   m.erase(7);
+//   for (auto& [k, v] : m) ...
+//
+// The backing array of a table with `capacity` slots (`capacity + 1` a power
+// of 2) is
+//
+//   Layout<ctrl_t, Aligned<Slot, 16>>(capacity + kGroupWidth, capacity)
+//
+// i.e. one control byte per slot, a sentinel, a copy of the first
+// `kGroupWidth - 1` control bytes (so that a group read at any slot never
+// wraps), then the slots. One allocation per table; growing allocates a new
+// block of twice the capacity and rehashes into it.
+//
+// A control byte is `kEmpty`, `kDeleted`, `kSentinel` or, for a full slot, the
+// low 7 bits of the key's hash (H2). A lookup probes groups of `kGroupWidth`
+// control bytes starting at H1 (the rest of the hash): one compare + movemask
+// finds the slots in the group whose H2 matches, so the keys of only ~1/128 of
+// the non-matching slots are ever compared, and one more finds whether the
+// group has an empty slot (the end of the probe sequence). Groups are 16 bytes
+// with SSE2, 32 with AVX2 and 8 bytes (SWAR) elsewhere. The width is part of
+// the block's layout, so it's chosen at compile time (`-mavx2`).
+//
+// Iterators and pointers to elements are invalidated by any insertion that
+// grows the table. Erasing leaves a tombstone (`kDeleted`); tombstones are
+// dropped when the table is rehashed.
+
+#ifndef ABSL_CONTAINER_INTERNAL_FLAT_HASH_MAP_H_
+#define ABSL_CONTAINER_INTERNAL_FLAT_HASH_MAP_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+using ctrl_t = int8_t;
+
+namespace flat_hash_map_internal {
+
+inline constexpr ctrl_t kEmpty = -128;
+inline constexpr ctrl_t kDeleted = -2;
+inline constexpr ctrl_t kSentinel = -1;
+
+inline bool IsFull(ctrl_t c) { return c >= 0; }
+
+// Bit `i` of a mask is slot `i` of a group.
+class BitMask {
+ public:
+  explicit BitMask(uint32_t mask) : mask_(mask) {}
+  explicit operator bool() const { return mask_ != 0; }
+  uint32_t bits() const { return mask_; }
+  unsigned Lowest() const { return __builtin_ctz(mask_); }
+
+  // Iterates the indices of the set bits.
+  BitMask begin() const { return *this; }
+  BitMask end() const { return BitMask(0); }
+  unsigned operator*() const { return Lowest(); }
+  BitMask& operator++() {
+    mask_ &= mask_ - 1;
+    return *this;
+  }
+  bool operator!=(const BitMask& o) const { return mask_ != o.mask_; }
+
+ private:
+  uint32_t mask_;
+};
+
+#if defined(__AVX2__)
+struct Group {
+  static constexpr size_t kWidth = 32;
+  explicit Group(const ctrl_t* p)
+      : ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))) {}
+  BitMask Match(ctrl_t h2) const {
+    return BitMask(static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_set1_epi8(h2), ctrl))));
+  }
+  BitMask MaskEmpty() const { return Match(kEmpty); }
+  // `kEmpty` and `kDeleted` are the only values below `kSentinel`.
+  BitMask MaskEmptyOrDeleted() const {
+    return BitMask(static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(kSentinel), ctrl))));
+  }
+  BitMask MaskFull() const {
+    return BitMask(~static_cast<uint32_t>(_mm256_movemask_epi8(ctrl)));
+  }
+  __m256i ctrl;
+};
+#elif defined(__SSE2__)
+struct Group {
+  static constexpr size_t kWidth = 16;
+  explicit Group(const ctrl_t* p)
+      : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+  BitMask Match(ctrl_t h2) const {
+    return BitMask(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))));
+  }
+  BitMask MaskEmpty() const { return Match(kEmpty); }
+  BitMask MaskEmptyOrDeleted() const {
+    return BitMask(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl))));
+  }
+  BitMask MaskFull() const {
+    return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(ctrl)) ^ 0xffff);
+  }
+  __m128i ctrl;
+};
+#else
+// 8 control bytes in a word; each mask bit is the top bit of a byte, so the
+// masks are compacted to one bit per byte before use.
+struct Group {
+  static constexpr size_t kWidth = 8;
+  static constexpr uint64_t kLsbs = 0x0101010101010101;
+  static constexpr uint64_t kMsbs = 0x8080808080808080;
+  explicit Group(const ctrl_t* p) { memcpy(&ctrl, p, sizeof(ctrl)); }
+  static BitMask Compact(uint64_t msbs) {
+    return BitMask(static_cast<uint32_t>(((msbs >> 7) * 0x0102040810204080) >>
+                                         56));
+  }
+  BitMask Match(ctrl_t h2) const {
+    // Bytes equal to h2 become 0; set the top bit of exactly those bytes.
+    const uint64_t x = ctrl ^ (kLsbs * static_cast<uint8_t>(h2));
+    return Compact(~(((x & ~kMsbs) + ~kMsbs) | x | ~kMsbs));
+  }
+  BitMask MaskEmpty() const { return Match(kEmpty); }
+  BitMask MaskEmptyOrDeleted() const {
+    // Negative and not kSentinel (0xff): top bit set and not all bits set.
+    return Compact(ctrl & ~(ctrl << 7) & kMsbs);
+  }
+  BitMask MaskFull() const { return Compact(~ctrl & kMsbs); }
+  uint64_t ctrl;
+};
+#endif
+
+inline constexpr size_t kGroupWidth = Group::kWidth;
+
+// Spreads the entropy of the hash over all bits (std::hash of an integer is
+// the identity).
+inline size_t Mix(size_t h) {
+  const __uint128_t m = static_cast<__uint128_t>(h) * 0x9e3779b97f4a7c15;
+  return static_cast<size_t>(m) ^ static_cast<size_t>(m >> 64);
+}
+
+inline size_t H1(size_t hash) { return hash >> 7; }
+inline ctrl_t H2(size_t hash) { return static_cast<ctrl_t>(hash & 0x7f); }
+
+// Slots that may be full before the table grows: a load factor of 7/8, and
+// at least one empty slot so that every probe sequence ends.
+inline size_t CapacityToGrowth(size_t capacity) {
+  return capacity == 7 ? 6 : capacity - capacity / 8;
+}
+
+// Triangular probing over groups: visits every group once when the number of
+// groups is a power of 2.
+class ProbeSeq {
+ public:
+  ProbeSeq(size_t hash, size_t mask) : mask_(mask), offset_(hash & mask) {}
+  size_t offset() const { return offset_; }
+  size_t offset(size_t i) const { return (offset_ + i) & mask_; }
+  void next() {
+    index_ += kGroupWidth;
+    offset_ = (offset_ + index_) & mask_;
+  }
+
+ private:
+  size_t mask_;
+  size_t offset_;
+  size_t index_ = 0;
+};
+
+}  // namespace flat_hash_map_internal
+
+template <class K, class V, class Hash = std::hash<K>,
+          class Eq = std::equal_to<K>>
+class FlatHashMap {
+  using Slot = std::pair<K, V>;
+  static constexpr size_t kSlotAlign = alignof(Slot) > 16 ? alignof(Slot) : 16;
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Slot;
+  // The backing block.
+  using L = Layout<ctrl_t, Aligned<Slot, kSlotAlign>>;
+
+  template <bool kConst>
+  class Iterator {
+    using Ref = std::conditional_t<kConst, const Slot&, Slot&>;
+    using Ptr = std::conditional_t<kConst, const Slot*, Slot*>;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Slot;
+    using difference_type = ptrdiff_t;
+    using pointer = Ptr;
+    using reference = Ref;
+
+    Iterator() = default;
+    // iterator -> const_iterator.
+    template <bool kOtherConst>
+      requires(kConst && !kOtherConst)
+    Iterator(const Iterator<kOtherConst>& it)
+        : ctrl_(it.ctrl_), slot_(it.slot_) {}
+
+    Ref operator*() const { return *slot_; }
+    Ptr operator->() const { return slot_; }
+    Iterator& operator++() {
+      ++ctrl_;
+      ++slot_;
+      SkipEmpty();
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto t = *this;
+      ++*this;
+      return t;
+    }
+    bool operator==(const Iterator& o) const { return ctrl_ == o.ctrl_; }
+    bool operator!=(const Iterator& o) const { return ctrl_ != o.ctrl_; }
+
+   private:
+    friend class FlatHashMap;
+    friend class Iterator<!kConst>;
+    Iterator(const ctrl_t* ctrl, Ptr slot) : ctrl_(ctrl), slot_(slot) {}
+
+    // Advances to the next full slot or to the sentinel.
+    void SkipEmpty() {
+      namespace fi = flat_hash_map_internal;
+      while (*ctrl_ < fi::kSentinel) {
+        // Number of empty or deleted slots at the start of the group. Counted
+        // in 64 bits: a 32-wide group with no full slot skips all 32.
+        const size_t skip = __builtin_ctzll(
+            ~uint64_t{fi::Group(ctrl_).MaskEmptyOrDeleted().bits()});
+        ctrl_ += skip;
+        slot_ += skip;
+      }
+    }
+
+    const ctrl_t* ctrl_ = nullptr;
+    Ptr slot_ = nullptr;
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+  explicit FlatHashMap(size_t bucket_count) { reserve(bucket_count); }
+
+  FlatHashMap(FlatHashMap&& other) noexcept
+      : block_(std::exchange(other.block_, nullptr)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        size_(std::exchange(other.size_, 0)),
+        growth_left_(std::exchange(other.growth_left_, 0)) {}
+
+  FlatHashMap& operator=(FlatHashMap&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      block_ = std::exchange(other.block_, nullptr);
+      capacity_ = std::exchange(other.capacity_, 0);
+      size_ = std::exchange(other.size_, 0);
+      growth_left_ = std::exchange(other.growth_left_, 0);
+    }
+    return *this;
+  }
+
+  FlatHashMap(const FlatHashMap&) = delete;
+  FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+  ~FlatHashMap() { Destroy(); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return capacity_; }
+  // The layout of the backing block; `AllocSize()` is the table's footprint.
+  L layout() const { return MakeLayout(capacity_); }
+
+  iterator begin() {
+    if (capacity_ == 0) return end();
+    iterator it(ctrl(), slots());
+    it.SkipEmpty();
+    return it;
+  }
+  iterator end() { return iterator(ctrl() + capacity_, nullptr); }
+  const_iterator begin() const {
+    return const_cast<FlatHashMap*>(this)->begin();
+  }
+  const_iterator end() const { return const_cast<FlatHashMap*>(this)->end(); }
+
+  iterator find(const K& key) {
+    if (capacity_ == 0) return end();
+    const size_t i = Find(key, Hash1(key));
+    return i == capacity_ ? end() : iterator(ctrl() + i, slots() + i);
+  }
+  const_iterator find(const K& key) const {
+    return const_cast<FlatHashMap*>(this)->find(key);
+  }
+  bool contains(const K& key) const { return find(key) != end(); }
+
+  // Inserts `(key, V(args...))` unless `key` is present. Returns the element
+  // with `key` and whether it was inserted.
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+    const size_t hash = Hash1(key);
+    if (capacity_ != 0) {
+      const size_t i = Find(key, hash);
+      if (i != capacity_) return {iterator(ctrl() + i, slots() + i), false};
+    }
+    const size_t i = PrepareInsert(hash);
+    new (slots() + i) Slot(std::piecewise_construct, std::forward_as_tuple(key),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+    return {iterator(ctrl() + i, slots() + i), true};
+  }
+
+  std::pair<iterator, bool> insert(const K& key, V value) {
+    return try_emplace(key, std::move(value));
+  }
+
+  V& operator[](const K& key) { return try_emplace(key).first->second; }
+
+  size_t erase(const K& key) {
+    auto it = find(key);
+    if (it == end()) return 0;
+    erase(it);
+    return 1;
+  }
+
+  void erase(iterator it) {
+    namespace fi = flat_hash_map_internal;
+    const size_t i = it.ctrl_ - ctrl();
+    it.slot_->~Slot();
+    --size_;
+    // If no window of `kGroupWidth` control bytes around `i` was ever full,
+    // no probe sequence went past `i`, and the slot can be empty again rather
+    // than a tombstone.
+    const size_t before = (i - fi::kGroupWidth) & capacity_;
+    const uint32_t empty_after = fi::Group(ctrl() + i).MaskEmpty().bits();
+    const uint32_t empty_before =
+        fi::Group(ctrl() + before).MaskEmpty().bits();
+    const bool was_never_full =
+        empty_before != 0 && empty_after != 0 &&
+        __builtin_ctz(empty_after) +
+                (__builtin_clz(empty_before) - (32 - fi::kGroupWidth)) <
+            fi::kGroupWidth;
+    SetCtrl(i, was_never_full ? fi::kEmpty : fi::kDeleted);
+    growth_left_ += was_never_full;
+  }
+
+  void clear() {
+    Destroy();
+    capacity_ = size_ = growth_left_ = 0;
+  }
+
+  // Makes room for `n` elements without rehashing.
+  void reserve(size_t n) {
+    if (n > size_ + growth_left_) Resize(CapacityFor(n));
+  }
+
+ private:
+  static L MakeLayout(size_t capacity) {
+    return L(capacity + flat_hash_map_internal::kGroupWidth, capacity);
+  }
+
+  ctrl_t* ctrl() const { return L::Partial().template Pointer<0>(block_); }
+  Slot* slots() const {
+    return MakeLayout(capacity_).template Pointer<1>(block_);
+  }
+
+  static size_t Hash1(const K& key) {
+    return flat_hash_map_internal::Mix(Hash()(key));
+  }
+
+  // Smallest valid capacity that holds `n` elements.
+  static size_t CapacityFor(size_t n) {
+    namespace fi = flat_hash_map_internal;
+    size_t capacity = fi::kGroupWidth - 1;
+    while (fi::CapacityToGrowth(capacity) < n) capacity = capacity * 2 + 1;
+    return capacity;
+  }
+
+  // Index of the slot holding `key`, or `capacity_`.
+  size_t Find(const K& key, size_t hash) const {
+    namespace fi = flat_hash_map_internal;
+    const ctrl_t* c = ctrl();
+    const Slot* s = slots();
+    fi::ProbeSeq seq(fi::H1(hash), capacity_);
+    for (;;) {
+      const fi::Group g(c + seq.offset());
+      for (unsigned j : g.Match(fi::H2(hash))) {
+        const size_t i = seq.offset(j);
+        if (Eq()(s[i].first, key)) return i;
+      }
+      if (g.MaskEmpty()) return capacity_;
+      seq.next();
+    }
+  }
+
+  // First empty or deleted slot on the probe sequence of `hash`.
+  size_t FindFirstNonFull(size_t hash) const {
+    namespace fi = flat_hash_map_internal;
+    fi::ProbeSeq seq(fi::H1(hash), capacity_);
+    for (;;) {
+      const fi::Group g(ctrl() + seq.offset());
+      if (auto mask = g.MaskEmptyOrDeleted()) return seq.offset(mask.Lowest());
+      seq.next();
+    }
+  }
+
+  // A slot for a new element with `hash`; grows the table if needed.
+  size_t PrepareInsert(size_t hash) {
+    namespace fi = flat_hash_map_internal;
+    if (capacity_ == 0) Resize(CapacityFor(1));
+    size_t i = FindFirstNonFull(hash);
+    if (growth_left_ == 0 && ctrl()[i] != fi::kDeleted) {
+      // Full of elements and tombstones: grow, or just drop the tombstones if
+      // at most half of the slots hold elements.
+      Resize(size_ * 2 > capacity_ ? capacity_ * 2 + 1 : capacity_);
+      i = FindFirstNonFull(hash);
+    }
+    growth_left_ -= ctrl()[i] == fi::kEmpty;
+    ++size_;
+    SetCtrl(i, fi::H2(hash));
+    return i;
+  }
+
+  // Sets control byte `i` and its copy after the sentinel.
+  void SetCtrl(size_t i, ctrl_t h) {
+    namespace fi = flat_hash_map_internal;
+    ctrl_t* c = ctrl();
+    c[i] = h;
+    if (i < fi::kGroupWidth - 1) c[capacity_ + 1 + i] = h;
+  }
+
+  // Moves the elements into a new block of `capacity` slots.
+  void Resize(size_t capacity) {
+    namespace fi = flat_hash_map_internal;
+    assert(((capacity + 1) & capacity) == 0 && capacity >= size_);
+    unsigned char* old_block = block_;
+    const size_t old_capacity = capacity_;
+    const ctrl_t* old_ctrl = old_block ? ctrl() : nullptr;
+    Slot* old_slots = old_block ? slots() : nullptr;
+
+    const L layout = MakeLayout(capacity);
+    block_ = static_cast<unsigned char*>(
+        ::operator new(layout.AllocSize(), std::align_val_t{L::Alignment()}));
+    capacity_ = capacity;
+    ctrl_t* c = ctrl();
+    memset(c, fi::kEmpty, capacity + fi::kGroupWidth);
+    c[capacity] = fi::kSentinel;
+    growth_left_ = fi::CapacityToGrowth(capacity) - size_;
+
+    Slot* s = slots();
+    for (size_t i = 0; i != old_capacity; ++i) {
+      if (!fi::IsFull(old_ctrl[i])) continue;
+      const size_t hash = Hash1(old_slots[i].first);
+      const size_t j = FindFirstNonFull(hash);
+      SetCtrl(j, fi::H2(hash));
+      new (s + j) Slot(std::move(old_slots[i]));
+      old_slots[i].~Slot();
+    }
+    ::operator delete(old_block, std::align_val_t{L::Alignment()});
+  }
+
+  void Destroy() {
+    if (block_ == nullptr) return;
+    if constexpr (!std::is_trivially_destructible_v<Slot>) {
+      const ctrl_t* c = ctrl();
+      Slot* s = slots();
+      for (size_t i = 0; i != capacity_; ++i) {
+        if (flat_hash_map_internal::IsFull(c[i])) s[i].~Slot();
+      }
+    }
+    ::operator delete(block_, std::align_val_t{L::Alignment()});
+    block_ = nullptr;
+  }
+
+  unsigned char* block_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t growth_left_ = 0;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_FLAT_HASH_MAP_H_
@@ -0,0 +1,157 @@
+// A move-only handle to a variable-size object: a header struct followed by
+// trailing arrays, in one allocation laid out by `Layout<Header, Ts...>`.
+//
+// It's `MyCompactFoo` (test_serialize.cpp) without the pointer members: the
+// array sizes live in the header, and every accessor rebuilds the layout from
+// them, so reaching an array costs a few adds rather than a pointer load.
+//
+//   struct FooHeader {
+//     uint32_t id;
+//     uint32_t num_floats;
+//     uint32_t num_doubles;
+//     std::array<size_t, 2> counts() const { return {num_floats, num_doubles}; }
+//   };
+//   using Foo = FlexObject<FooHeader, float, double>;
+//
+//   Foo foo = Foo::Make(FooHeader{7, 3, 4});  // arrays value-initialized
+//   foo.Pointer<0>()[2] = 3.3f;               // float[3]
+//   for (double d : foo.Slice<1>()) ...       // double[4]
+//   foo->id;                                  // the header
+//
+// `counts()` must return the sizes of the trailing arrays, in order (anything
+// indexable by `size_t`). It's read by every accessor and by the destructor,
+// so the count members must not change after `Make()`.
+//
+// The block is allocated with the sized, aligned `operator new` and released
+// with the matching sized `operator delete`, both with `AllocSize()` of the
+// rebuilt layout. Array elements are constructed in `Make()` and destroyed by
+// the handle, so they need not be trivial.
+
+#ifndef ABSL_CONTAINER_INTERNAL_FLEX_OBJECT_H_
+#define ABSL_CONTAINER_INTERNAL_FLEX_OBJECT_H_
+
+#include <stddef.h>
+
+#include <concepts>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+template <class Header, class... Ts>
+class FlexObject {
+ public:
+  using L = Layout<Header, Ts...>;
+  static constexpr size_t kNumArrays = sizeof...(Ts);
+
+  static_assert(kNumArrays > 0, "Use a plain struct if there are no arrays");
+  static_assert(
+      requires(const Header& h) {
+        { h.counts()[size_t{0}] } -> std::convertible_to<size_t>;
+      },
+      "Header must have a counts() member returning the array sizes");
+
+  // Allocates an object with a copy of `header` and `header.counts()`
+  // value-initialized elements in each array.
+  static FlexObject Make(const Header& header) {
+    const L layout = LayoutFor(header);
+    unsigned char* p = static_cast<unsigned char*>(::operator new(
+        layout.AllocSize(), std::align_val_t{L::Alignment()}));
+    layout.PoisonPadding(p);
+    new (layout.template Pointer<0>(p)) Header(header);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (std::uninitialized_value_construct_n(layout.template Pointer<I + 1>(p),
+                                            layout.template Size<I + 1>()),
+       ...);
+    }(std::make_index_sequence<kNumArrays>());
+    return FlexObject(p);
+  }
+
+  FlexObject() = default;
+  FlexObject(const FlexObject&) = delete;
+  FlexObject& operator=(const FlexObject&) = delete;
+
+  FlexObject(FlexObject&& other) noexcept
+      : p_(std::exchange(other.p_, nullptr)) {}
+
+  FlexObject& operator=(FlexObject&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      p_ = std::exchange(other.p_, nullptr);
+    }
+    return *this;
+  }
+
+  ~FlexObject() { Destroy(); }
+
+  explicit operator bool() const { return p_ != nullptr; }
+
+  // The header; requires a non-empty handle.
+  Header& header() { return *kHeader.template Pointer<0>(p_); }
+  const Header& header() const { return *kHeader.template Pointer<0>(p_); }
+  Header* operator->() { return &header(); }
+  const Header* operator->() const { return &header(); }
+
+  // The layout of this object, rebuilt from the header's counts.
+  L layout() const { return LayoutFor(header()); }
+
+  // The `I`-th trailing array (zero-based, not counting the header).
+  template <size_t I>
+  auto Pointer() {
+    return layout().template Pointer<I + 1>(p_);
+  }
+  template <size_t I>
+  auto Pointer() const {
+    return layout().template Pointer<I + 1>(
+        static_cast<const unsigned char*>(p_));
+  }
+  template <size_t I>
+  auto Slice() {
+    return layout().template Slice<I + 1>(p_);
+  }
+  template <size_t I>
+  auto Slice() const {
+    return layout().template Slice<I + 1>(
+        static_cast<const unsigned char*>(p_));
+  }
+
+  // The whole block: `size()` bytes aligned to `L::Alignment()`.
+  const unsigned char* data() const { return p_; }
+  size_t size() const { return p_ == nullptr ? 0 : layout().AllocSize(); }
+
+ private:
+  static constexpr auto kHeader = L::Partial(1);
+
+  explicit FlexObject(unsigned char* p) : p_(p) {}
+
+  static L LayoutFor(const Header& h) {
+    const auto counts = h.counts();
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+      return L(1, static_cast<size_t>(counts[I])...);
+    }(std::make_index_sequence<kNumArrays>());
+  }
+
+  void Destroy() {
+    if (p_ == nullptr) return;
+    const L layout = this->layout();
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (std::destroy_n(layout.template Pointer<I + 1>(p_),
+                      layout.template Size<I + 1>()),
+       ...);
+    }(std::make_index_sequence<kNumArrays>());
+    std::destroy_at(layout.template Pointer<0>(p_));
+    ::operator delete(p_, layout.AllocSize(), std::align_val_t{L::Alignment()});
+    p_ = nullptr;
+  }
+
+  unsigned char* p_ = nullptr;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_FLEX_OBJECT_H_
@@ -0,0 +1,166 @@
+// A variable-length array of variable-length records (a.k.a. CSR, compressed
+// sparse row) in one aligned block.
+//
+// `Layout` handles a fixed number of arrays. `JaggedLayout<T>` handles N rows
+// where row `i` is an array of `T` with its own length, e.g. N strings or N
+// adjacency lists. The block is
+//
+//   uint64_t[1]       rows      number of rows N
+//   uint64_t[1]       values    total number of elements M
+//   uint64_t[N + 1]   offsets   row i is values[offsets[i], offsets[i + 1])
+//   T[M]              data      all rows, back to back
+//
+// Offsets are indices relative to the data array, not pointers, so the block
+// can be written to a file or a socket and used in place after mmap()/recv()
+// at any address aligned to `Alignment()`.
+//
+//   std::vector<std::vector<int>> adj = {{1, 2}, {}, {0, 1, 2}};
+//   unsigned char* p = JaggedLayout<int>::Create(adj);
+//   JaggedLayout<int> g(p);
+//   assert(g.size() == 3);
+//   for (int v : g.Row(2)) ...    // 0 1 2
+//   JaggedLayout<int>::Destroy(p);
+
+#ifndef ABSL_CONTAINER_INTERNAL_JAGGED_LAYOUT_H_
+#define ABSL_CONTAINER_INTERNAL_JAGGED_LAYOUT_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+template <class T>
+class JaggedLayout {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Rows are copied with memcpy and used in place after mmap");
+
+  using L = Layout<Field<"rows", uint64_t>, Field<"values", uint64_t>,
+                   Field<"offsets", uint64_t>, Field<"data", T>>;
+
+  static constexpr size_t Alignment() { return L::Alignment(); }
+
+  // The layout of a block with `rows` rows and `values` elements in total.
+  static constexpr L MakeLayout(size_t rows, size_t values) {
+    return L(1, 1, rows + 1, values);
+  }
+
+  static constexpr size_t AllocSize(size_t rows, size_t values) {
+    return MakeLayout(rows, values).AllocSize();
+  }
+
+  // Writes the block for `rows` into `p`. `Rows` is a range of ranges of `T`
+  // with `size()` and `data()`, e.g. `std::vector<std::vector<T>>`.
+  //
+  // Requires: `p` is aligned to `Alignment()` and points to at least
+  // `AllocSize(rows.size(), <total elements>)` bytes.
+  template <class Rows>
+  static void Build(const Rows& rows, unsigned char* p) {
+    const L layout = MakeLayout(rows.size(), TotalSize(rows));
+    *layout.template Pointer<"rows">(p) = rows.size();
+    *layout.template Pointer<"values">(p) = layout.template Size<"data">();
+
+    uint64_t* offsets = layout.template Pointer<"offsets">(p);
+    T* data = layout.template Pointer<"data">(p);
+    uint64_t off = 0;
+    size_t i = 0;
+    for (const auto& row : rows) {
+      offsets[i++] = off;
+      if (row.size() != 0) {
+        memcpy(static_cast<void*>(data + off), row.data(),
+               sizeof(T) * row.size());
+      }
+      off += row.size();
+    }
+    offsets[i] = off;
+  }
+
+  // Allocates a block with the aligned `operator new` and builds it. The
+  // caller releases it with `Destroy()`.
+  template <class Rows>
+  static unsigned char* Create(const Rows& rows) {
+    const size_t size = AllocSize(rows.size(), TotalSize(rows));
+    unsigned char* p = static_cast<unsigned char*>(
+        ::operator new(size, std::align_val_t{Alignment()}));
+    Build(rows, p);
+    return p;
+  }
+
+  // Releases a block returned by `Create()`.
+  static void Destroy(unsigned char* p) {
+    ::operator delete(p, std::align_val_t{Alignment()});
+  }
+
+  // A read-only view of the block at `p`. Cheap: reads the two counts.
+  //
+  // Requires: `p` is aligned to `Alignment()` and holds a block written by
+  // `Build()`.
+  explicit JaggedLayout(const unsigned char* p) : p_(p) {
+    constexpr auto prefix = L::Partial(1, 1);
+    rows_ = *prefix.template Pointer<"rows">(p);
+    const L layout = MakeLayout(rows_, *prefix.template Pointer<"values">(p));
+    offsets_ = layout.template Pointer<"offsets">(p);
+    data_ = layout.template Pointer<"data">(p);
+    alloc_size_ = layout.AllocSize();
+  }
+
+  // Number of rows.
+  size_t size() const { return rows_; }
+
+  // Total number of elements in all rows.
+  size_t num_values() const { return offsets_[rows_]; }
+
+  size_t AllocSize() const { return alloc_size_; }
+
+  const unsigned char* data() const { return p_; }
+
+  // Number of elements in row `i`.
+  size_t RowSize(size_t i) const {
+    assert(i < rows_);
+    return offsets_[i + 1] - offsets_[i];
+  }
+
+  // Row `i`. O(1).
+  internal_layout::SliceType<const T> Row(size_t i) const {
+    assert(i < rows_);
+    return {data_ + offsets_[i], offsets_[i + 1] - offsets_[i]};
+  }
+
+  // The offsets column: `size() + 1` entries, the last one is `num_values()`.
+  internal_layout::SliceType<const uint64_t> Offsets() const {
+    return {offsets_, rows_ + 1};
+  }
+
+  // The values column: all rows back to back.
+  internal_layout::SliceType<const T> Values() const {
+    return {data_, num_values()};
+  }
+
+ private:
+  template <class Rows>
+  static size_t TotalSize(const Rows& rows) {
+    size_t n = 0;
+    for (const auto& row : rows) n += row.size();
+    return n;
+  }
+
+  const unsigned char* p_;
+  const uint64_t* offsets_;
+  const T* data_;
+  size_t rows_;
+  size_t alloc_size_;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_JAGGED_LAYOUT_H_
@@ -95,6 +95,32 @@
 // array of `T` is aligned to `N` (the rest of the elements follow without
 // padding). `N` cannot be less than `alignof(T)`.
 //
+// Fields can also be given compile-time names with `Field<"name", T>`. Named
+// fields are addressed with `Pointer<"name">(p)`, `Slice<"name">(p)` etc.,
+// which resolve to the same constant offset arithmetic as `Pointer<N>(p)`.
+// Unlike the type-based form, this works when element types repeat.
+//
+//   using L = Layout<Field<"ts", uint64_t>, Field<"seq", uint64_t>>;
+//   const L layout(n, n);
+//   uint64_t* seq = layout.Pointer<"seq">(p);
+//
+// Flags and small enums can be stored with `Bits<K>`: an array of `n` values
+// of `K` bits takes `ceil(n * K / 64)` 64-bit words. `Size<N>()` is still the
+// number of values, `Pointer<N>(p)` points to the words and `Slice<N>(p)` is a
+// `BitSpan` with `[]`, `Count()`, `Rank()`, `Select()` and `Unpack()`.
+//
+//   using L = Layout<Field<"ts", uint64_t>, Field<"null", Bits<1>>>;
+//   const L layout(n, n);
+//   auto nulls = layout.Slice<"null">(p);
+//   nulls[i] = 1;
+//
+// Arrays of equal length can be walked row by row with `Zip<N...>(p)`, a
+// random-access range of tuples of references (see zip_range.h).
+//
+//   using L = Layout<float, float, float>;
+//   const L layout(n, n, n);
+//   for (auto [x, y, sum] : layout.Zip<0, 1, 2>(p)) sum = x + y;
+//
 // `AllocSize()` and `Pointer()` are the most basic methods for dealing with
 // memory layouts. Check out the reference or code below to discover more.
 //
@@ -163,6 +189,10 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <optional>
 #include <ostream>
 #include <string>
 #include <tuple>
@@ -178,6 +208,9 @@
 #include <boost/beast/core/span.hpp>
 #include <fmt/format.h>
 
+#include "bit_span.h"
+#include "zip_range.h"
+
 #if defined(__GXX_RTTI)
 #define ABSL_INTERNAL_HAS_CXA_DEMANGLE
 #endif
@@ -205,6 +238,44 @@ namespace container_internal {
 template <class T, size_t N>
 struct Aligned;
 
+// A string literal that can be passed as a template argument, e.g. the name in
+// `Field<"ts", uint64_t>`.
+template <size_t N>
+struct FixedString {
+  constexpr FixedString(const char (&s)[N]) {
+    for (size_t i = 0; i != N; ++i) data[i] = s[i];
+  }
+
+  template <size_t M>
+  constexpr bool operator==(const FixedString<M>& other) const {
+    if (N != M) return false;
+    for (size_t i = 0; i != N; ++i) {
+      if (data[i] != other.data[i]) return false;
+    }
+    return true;
+  }
+
+  char data[N];
+};
+
+// A type wrapper that gives the array a compile-time name.
+// `Layout<..., Field<"x", T>, ...>` has exactly the same memory layout and API
+// as `Layout<..., T, ...>`, and additionally lets you write `Pointer<"x">(p)`,
+// `Slice<"x">(p)`, `Offset<"x">()` and `Size<"x">()`. Names must be unique
+// within a layout. `T` may itself be `Aligned<U, N>`.
+//
+// Yuanguo: 和Aligned一样，只用于传递类型信息，不能构造对象；
+template <FixedString Name, class T>
+struct Field;
+
+// A type wrapper for an array of unsigned `K`-bit values, `0 < K <= 64`,
+// packed into `uint64_t` words (see bit_span.h). The element type seen by
+// `Pointer()` is `uint64_t`; `Slice()` returns a `BitSpan<K, uint64_t>`.
+//
+// Yuanguo: 和Aligned/Field一样，只用于传递类型信息，不能构造对象；
+template <size_t K>
+struct Bits;
+
 namespace internal_layout {
 
 // Yuanguo: NotAligned模版及其偏特化，主要是和Type, SizeOf, AlignOf配合使用，限制
@@ -271,6 +342,54 @@ struct AlignOf<Aligned<T, N>> {
   static constexpr size_t value = N;
 };
 
+// Yuanguo: Field<Name, T>只是给T起个名字，类型、大小、对齐都取自T（T可以是Aligned）；
+template <FixedString Name, class T>
+struct Type<Field<Name, T>> : Type<T> {};
+
+template <FixedString Name, class T>
+struct SizeOf<Field<Name, T>> : SizeOf<T> {};
+
+template <FixedString Name, class T>
+struct AlignOf<Field<Name, T>> : AlignOf<T> {};
+
+// Yuanguo: Bits<K>的数组存放在uint64_t的word中；
+template <size_t K>
+struct Type<Bits<K>> {
+  static_assert(K > 0 && K <= 64, "Bits<K> requires 0 < K <= 64");
+  using type = uint64_t;
+};
+
+template <size_t K>
+struct SizeOf<Bits<K>> : std::integral_constant<size_t, sizeof(uint64_t)> {};
+
+template <size_t K>
+struct AlignOf<Bits<K>> {
+  // Not alignof(uint64_t), which is 4 on some 32-bit ABIs: word arrays start
+  // at the same offsets on every host.
+  static constexpr size_t value = sizeof(uint64_t);
+};
+
+// `K` for `Bits<K>` (possibly wrapped in `Field`/`Aligned`), 0 otherwise.
+template <class T>
+struct BitsPerValue : std::integral_constant<size_t, 0> {};
+
+template <size_t K>
+struct BitsPerValue<Bits<K>> : std::integral_constant<size_t, K> {};
+
+template <class T, size_t N>
+struct BitsPerValue<Aligned<T, N>> : BitsPerValue<T> {};
+
+template <FixedString Name, class T>
+struct BitsPerValue<Field<Name, T>> : BitsPerValue<T> {};
+
+// Is `T` a `Field<Name, U>` for some `U`?
+template <FixedString Name, class T>
+struct HasName : std::false_type {};
+
+template <FixedString Name, FixedString Other, class T>
+struct HasName<Name, Field<Other, T>>
+    : std::integral_constant<bool, Name == Other> {};
+
 // Does `Ts...` contain `T`?
 template <class T, class... Ts>
 using Contains = std::disjunction<std::is_same<T, Ts>...>;
@@ -312,6 +431,24 @@ using CopyConst =
 template <class T>
 using SliceType = boost::beast::span<T>;
 
+// The type returned by `Slice()` for an array declared as `T` whose elements
+// are `Word`s: a `SliceType`, or a `BitSpan` for `Bits<K>`.
+template <class T, class Word>
+struct SliceOf {
+  using type = SliceType<Word>;
+};
+
+template <size_t K, class Word>
+struct SliceOf<Bits<K>, Word> {
+  using type = BitSpan<K, Word>;
+};
+
+template <class T, size_t N, class Word>
+struct SliceOf<Aligned<T, N>, Word> : SliceOf<T, Word> {};
+
+template <FixedString Name, class T, class Word>
+struct SliceOf<Field<Name, T>, Word> : SliceOf<T, Word> {};
+
 // This namespace contains no types. It prevents functions defined in it from
 // being found by ADL.
 namespace adl_barrier {
@@ -327,6 +464,30 @@ constexpr size_t Find(Needle, T, Ts...) {
   return adl_barrier::Find(Needle(), Ts()...) + 1;
 }
 
+// Index of the only `true` in `matches`, or `N` if there isn't exactly one.
+template <size_t N>
+constexpr size_t FindUnique(const bool (&matches)[N]) {
+  size_t res = N, count = 0;
+  for (size_t i = 0; i != N; ++i) {
+    if (matches[i]) {
+      res = i;
+      ++count;
+    }
+  }
+  return count == 1 ? res : N;
+}
+
+// True if no two elements of `a` are equal.
+template <size_t N>
+constexpr bool AllDistinct(const std::array<size_t, N>& a) {
+  for (size_t i = 0; i != N; ++i) {
+    for (size_t j = i + 1; j != N; ++j) {
+      if (a[i] == a[j]) return false;
+    }
+  }
+  return true;
+}
+
 constexpr bool IsPow2(size_t n) { return !(n & (n - 1)); }
 
 // Returns `q * m` for the smallest `q` such that `q * m >= n`.
@@ -335,6 +496,38 @@ constexpr size_t Align(size_t n, size_t m) { return (n + m - 1) & ~(m - 1); }
 
 constexpr size_t Min(size_t a, size_t b) { return b < a ? b : a; }
 
+// Bytes taken by `n` elements of an array declared as `T`.
+template <class T>
+constexpr size_t ArrayBytes(size_t n) {
+  constexpr size_t kBits = BitsPerValue<T>::value;
+  if constexpr (kBits != 0) {
+    return Align(n * kBits, 64) / 8;
+  } else {
+    return SizeOf<T>() * n;
+  }
+}
+
+// `ArrayBytes<T>(n)` into `*bytes`. Returns true if it overflows `size_t`.
+template <class T>
+constexpr bool CheckedArrayBytes(size_t n, size_t* bytes) {
+  constexpr size_t kBits = BitsPerValue<T>::value;
+  if constexpr (kBits != 0) {
+    size_t bits = 0;
+    const bool overflow = __builtin_mul_overflow(n, kBits, &bits);
+    *bytes = bits / 64 * 8 + (bits % 64 != 0 ? 8 : 0);
+    return overflow;
+  } else {
+    return __builtin_mul_overflow(n, SizeOf<T>::value, bytes);
+  }
+}
+
+// `Align(n, m)` into `*res`. Returns true if it overflows `size_t`.
+constexpr bool CheckedAlign(size_t n, size_t m, size_t* res) {
+  const bool overflow = __builtin_add_overflow(n, m - 1, res);
+  *res &= ~(m - 1);
+  return overflow;
+}
+
 constexpr size_t Max(size_t a) { return a; }
 
 template <class... Ts>
@@ -361,8 +554,81 @@ std::string TypeName() {
   return out;
 }
 
+// Number of cache lines touched by `bytes` bytes starting at `offset`, assuming
+// the allocation itself starts on a cache-line boundary.
+constexpr size_t CacheLinesSpanned(size_t offset, size_t bytes, size_t line) {
+  return bytes == 0 ? 0 : (offset + bytes - 1) / line - offset / line + 1;
+}
+
+// Number of elements of an array (`n` elements of `size` bytes starting at
+// `offset`) that cross a cache-line boundary. The positions of the elements
+// modulo `line` repeat every `line / gcd(size, line)` elements, so we only need
+// to look at one period.
+inline size_t StraddlingCount(size_t offset, size_t size, size_t n,
+                              size_t line) {
+  if (n == 0 || size == 0) return 0;
+  const size_t period = line / std::gcd(size, line);
+  size_t per_period = 0, in_tail = 0;
+  const size_t tail = n % period;
+  for (size_t i = 0; i != period && i != n; ++i) {
+    const bool straddles = (offset + i * size) % line + size > line;
+    per_period += straddles;
+    if (i < tail) in_tail += straddles;
+  }
+  return n / period * per_period + in_tail;
+}
+
+// AllocSize() of the fields laid out in the given `order`.
+template <size_t N>
+size_t PackedSize(const std::array<size_t, N>& order,
+                  const std::array<size_t, N>& bytes,
+                  const std::array<size_t, N>& aligns) {
+  size_t end = 0;
+  for (size_t i : order) end = Align(end, aligns[i]) + bytes[i];
+  return end;
+}
+
 }  // namespace adl_barrier
 
+// True if every type in the tuple `Types` (e.g. `L::ElementTypes`) is
+// trivially copyable, so that a blob of them can be copied with `memcpy`.
+template <class Types>
+struct AllTriviallyCopyable;
+
+template <class... Ts>
+struct AllTriviallyCopyable<std::tuple<Ts...>>
+    : std::bool_constant<(std::is_trivially_copyable_v<Ts> && ...)> {};
+
+// Yuanguo: 假定cache line为64字节（x86与大部分ARM都是）；Stats()允许传入其它值；
+constexpr size_t kCacheLineSize = 64;
+
+// Per-array part of `LayoutStats`. See `LayoutImpl::Stats()`.
+struct FieldStats {
+  size_t offset = 0;       // offset of the first element
+  size_t bytes = 0;        // sizeof(element) * number of elements
+  size_t padding = 0;      // padding bytes in front of the array
+  size_t cache_lines = 0;  // cache lines touched by the array
+  size_t straddling = 0;   // elements that cross a cache-line boundary
+};
+
+// Padding and cache-line efficiency of a layout. See `LayoutImpl::Stats()`.
+template <size_t N>
+struct LayoutStats {
+  size_t cache_line_size = kCacheLineSize;
+  size_t alloc_size = 0;     // AllocSize()
+  size_t payload_bytes = 0;  // sum of FieldStats::bytes
+  size_t padding_bytes = 0;  // alloc_size - payload_bytes
+  double padding_ratio = 0;  // padding_bytes / alloc_size
+  std::array<FieldStats, N> fields{};
+
+  // The field order with the smallest AllocSize() for the same sizes (the
+  // lexicographically first one if there are several), the AllocSize() it
+  // would have, and how many bytes that saves.
+  std::array<size_t, N> min_padding_order{};
+  size_t min_padding_alloc_size = 0;
+  size_t reorder_savings = 0;
+};
+
 template <bool C>
 using EnableIf = typename std::enable_if_t<C, int>;
 
@@ -533,6 +799,16 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
                              Type<typename Type<Elements>::type>()...);
   }
 
+  // Returns the index of the field named `Name`. Results in a compilation
+  // error if `Elements...` doesn't contain exactly one `Field<Name, T>`.
+  template <FixedString Name>
+  static constexpr size_t NameIndex() {
+    constexpr bool kMatches[] = {HasName<Name, Elements>::value...};
+    constexpr size_t kIndex = adl_barrier::FindUnique(kMatches);
+    static_assert(kIndex != NumTypes, "Field name not found or not unique");
+    return kIndex;
+  }
+
   // Yuanguo: 获取第N个数组的元素类型的alignment；可以这样使用(需要把ElementAlignment改成public)；可这样使用：
   //          std::cout << L1::ElementAlignment<3>::value << std::endl;
   template <size_t N>
@@ -550,6 +826,17 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
   template <size_t N>
   using ElementType = typename std::tuple_element<N, ElementTypes>::type;
 
+  // The Nth template argument as written, e.g. `Field<"x", Bits<3>>`.
+  template <size_t N>
+  using ElementSpec =
+      typename std::tuple_element<N, std::tuple<Elements...>>::type;
+
+  // The type returned by `Slice<N>()`: `SliceType<T>`, or `BitSpan<K, ...>`
+  // for `Bits<K>`.
+  template <size_t N, class Char>
+  using SliceFor =
+      typename SliceOf<ElementSpec<N>, CopyConst<Char, ElementType<N>>>::type;
+
   //Yuanguo: 这个语法比较难理解；
   //  IntToSize<SizeSeq>... 对SizeSeq展开为：IntToSize<0>, IntToSize<1>, ...即size_t, size_t, ...
   //  sizes是一个序列，例如：4, 3, 2
@@ -621,9 +908,8 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
   template <size_t N, EnableIf<N != 0> = 0>
   constexpr size_t Offset() const {
     static_assert(N < NumOffsets, "Index out of bounds");
-    return adl_barrier::Align(
-        Offset<N - 1>() + SizeOf<ElementType<N - 1>>() * size_[N - 1],
-        ElementAlignment<N>::value);
+    return adl_barrier::Align(Offset<N - 1>() + ArrayBytes<N - 1>(),
+                              ElementAlignment<N>::value);
   }
 
   // Offset in bytes of the array with the specified element type. There must
@@ -643,6 +929,15 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
     return Offset<ElementIndex<T>()>();
   }
 
+  // Offset in bytes of the array named `Name` (see `Field`).
+  //
+  //   Layout<Field<"ts", uint64_t>, Field<"seq", uint32_t>> x(3, 4);
+  //   assert(x.Offset<"seq">() == 24);
+  template <FixedString Name>
+  constexpr size_t Offset() const {
+    return Offset<NameIndex<Name>()>();
+  }
+
   // Offsets in bytes of all arrays for which the offsets are known.
   //
   // Yuanguo: 获取所有**可计算**的offsets!（例如前2个数组的长度已知，则前3个数组的offset可计算）
@@ -685,6 +980,22 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
     return Size<ElementIndex<T>()>();
   }
 
+  // The number of elements in the array named `Name` (see `Field`).
+  template <FixedString Name>
+  constexpr size_t Size() const {
+    return Size<NameIndex<Name>()>();
+  }
+
+  // Bytes taken by the Nth array: `Size<N>() * sizeof(ElementType<N>)`, or
+  // whole words for `Bits<K>`.
+  //
+  // Requires: `N < NumSizes`.
+  template <size_t N>
+  constexpr size_t ArrayBytes() const {
+    static_assert(N < NumSizes, "Index out of bounds");
+    return adl_barrier::ArrayBytes<ElementSpec<N>>(size_[N]);
+  }
+
   // The number of elements of all arrays for which they are known.
   //
   // Yuanguo: 获取所有已知长度的数组的长度（元素个数）；
@@ -763,6 +1074,18 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
     return Pointer<ElementIndex<T>()>(p);
   }
 
+  // Pointer to the beginning of the array named `Name` (see `Field`).
+  //
+  //   Layout<Field<"ts", uint64_t>, Field<"seq", uint64_t>> x(3, 4);
+  //   unsigned char* p = new unsigned char[x.AllocSize()];
+  //   uint64_t* seq = x.Pointer<"seq">(p);  // same as x.Pointer<1>(p)
+  //
+  // Requires: `p` is aligned to `Alignment()`.
+  template <FixedString Name, class Char>
+  CopyConst<Char, ElementType<NameIndex<Name>()>>* Pointer(Char* p) const {
+    return Pointer<NameIndex<Name>()>(p);
+  }
+
   // Pointers to all arrays for which pointers are known.
   //
   // `Char` must be `[const] [signed|unsigned] char`.
@@ -832,8 +1155,8 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
   //       - Size<N>: 第N个数组的长度（元素个数）；
   //   - 所以，就是构造第N个数组的slice（整个数组）
   template <size_t N, class Char>
-  SliceType<CopyConst<Char, ElementType<N>>> Slice(Char* p) const {
-    return SliceType<CopyConst<Char, ElementType<N>>>(Pointer<N>(p), Size<N>());
+  SliceFor<N, Char> Slice(Char* p) const {
+    return SliceFor<N, Char>(Pointer<N>(p), Size<N>());
   }
 
   // The array with the specified element type. There must be exactly one
@@ -854,10 +1177,18 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
   //          - 它的size（元素个数）必须已知！
   // 其实是调用上一个实现；ElementIndex<T>()在**编译时**获取类型T的index；
   template <class T, class Char>
-  SliceType<CopyConst<Char, T>> Slice(Char* p) const {
+  SliceFor<ElementIndex<T>(), Char> Slice(Char* p) const {
     return Slice<ElementIndex<T>()>(p);
   }
 
+  // The array named `Name` (see `Field`).
+  //
+  // Requires: `p` is aligned to `Alignment()`.
+  template <FixedString Name, class Char>
+  SliceFor<NameIndex<Name>(), Char> Slice(Char* p) const {
+    return Slice<NameIndex<Name>()>(p);
+  }
+
   // All arrays with known sizes.
   //
   // `Char` must be `[const] [signed|unsigned] char`.
@@ -893,14 +1224,41 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
   //   - Slice<SizeSeq>(p)...：对SizeSeq展开，得到Slice<0>(p), Slice<1>(p), Slice<2>(p)；
   //     调用前面的Slice<size_t N, class Char>函数（注意：Char模版参数省略，由编译器自动推导）
   template <class Char>
-  std::tuple<SliceType<CopyConst<
-      Char, typename std::tuple_element<SizeSeq, ElementTypes>::type>>...>
-  Slices(Char* p) const {
+  std::tuple<SliceFor<SizeSeq, Char>...> Slices(Char* p) const {
     // Workaround for https://gcc.gnu.org/bugzilla/show_bug.cgi?id=63875 (fixed
     // in 6.1).
     (void)p;
-    return std::tuple<SliceType<CopyConst<Char, ElementType<SizeSeq>>>...>(
-        Slice<SizeSeq>(p)...);
+    return std::tuple<SliceFor<SizeSeq, Char>...>(Slice<SizeSeq>(p)...);
+  }
+
+  // Arrays `N...` walked row by row: row `i` is a tuple of references to
+  // element `i` of each of them (see zip_range.h).
+  //
+  // `Char` must be `[const] [signed|unsigned] char`.
+  //
+  //   // float[n], float[n], double[n].
+  //   Layout<float, float, double> x(n, n, n);
+  //   for (auto [a, b, c] : x.Zip<0, 1, 2>(p)) c = a * b;
+  //
+  // Requires: `N < NumSizes` for all `N`, and the arrays have equal sizes.
+  // Requires: `N...` are distinct.
+  // Requires: none of the arrays is `Bits<K>`.
+  // Requires: `p` is aligned to `Alignment()`.
+  template <size_t... N, class Char>
+  ZipRange<CopyConst<Char, ElementType<N>>...> Zip(Char* p) const {
+    static_assert(sizeof...(N) > 0, "Zip needs at least one array");
+    // The columns are passed as `__restrict` pointers by `ZipRange::ForEach`.
+    static_assert(
+        adl_barrier::AllDistinct(std::array<size_t, sizeof...(N)>{N...}),
+        "Zip arrays must be distinct");
+    static_assert((std::is_same_v<SliceFor<N, Char>,
+                                  SliceType<CopyConst<Char, ElementType<N>>>> &&
+                   ...),
+                  "Bits<K> arrays can't be zipped");
+    constexpr size_t kFirst = std::get<0>(std::array<size_t, sizeof...(N)>{N...});
+    assert(((Size<N>() == Size<kFirst>()) && ...));
+    return ZipRange<CopyConst<Char, ElementType<N>>...>(Size<kFirst>(),
+                                                        Pointer<N>(p)...);
   }
 
   // The size of the allocation that fits all arrays.
@@ -918,8 +1276,32 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
   //   实现：最后一个数组的offset + 最后一个数组元素大小 * 长度（元素个数）
   constexpr size_t AllocSize() const {
     static_assert(NumTypes == NumSizes, "You must specify sizes of all fields");
-    return Offset<NumTypes - 1>() +
-           SizeOf<ElementType<NumTypes - 1>>() * size_[NumTypes - 1];
+    return Offset<NumTypes - 1>() + ArrayBytes<NumTypes - 1>();
+  }
+
+  // `Offset<N>()`, or `std::nullopt` if the computation overflows `size_t`
+  // (e.g. for counts read from an untrusted header). The overflow flags of
+  // all steps are OR-ed together, so there is one branch at the end.
+  //
+  // Requires: `N <= NumSizes && N < sizeof...(Ts)`.
+  template <size_t N>
+  constexpr std::optional<size_t> CheckedOffset() const {
+    static_assert(N < NumOffsets, "Index out of bounds");
+    size_t res = 0;
+    bool overflow = CheckedEnd<N>(&res);
+    overflow |= adl_barrier::CheckedAlign(res, ElementAlignment<N>::value, &res);
+    if (overflow) return std::nullopt;
+    return res;
+  }
+
+  // `AllocSize()`, or `std::nullopt` if it doesn't fit in `size_t`.
+  //
+  // Requires: `NumSizes == sizeof...(Ts)`.
+  constexpr std::optional<size_t> CheckedAllocSize() const {
+    static_assert(NumTypes == NumSizes, "You must specify sizes of all fields");
+    size_t res = 0;
+    if (CheckedEnd<NumTypes>(&res)) return std::nullopt;
+    return res;
   }
 
   //Yuanguo: PoisonPadding是利用AddressSanitizer（ASAN）来标记填充区域（padding），
@@ -951,13 +1333,130 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
     PoisonPadding<Char, N - 1>(p);
     // The `if` is an optimization. It doesn't affect the observable behaviour.
     if (ElementAlignment<N - 1>::value % ElementAlignment<N>::value) {
-      size_t start =
-          Offset<N - 1>() + SizeOf<ElementType<N - 1>>() * size_[N - 1];
+      size_t start = Offset<N - 1>() + ArrayBytes<N - 1>();
       ASAN_POISON_MEMORY_REGION(p + start, Offset<N>() - start);
     }
 #endif
   }
 
+  // Padding and cache-line statistics of the layout. Slow.
+  //
+  // Cache-line numbers assume that the allocation starts on a
+  // `cache_line_size` boundary.
+  //
+  //   // char[3], 1 byte of padding, int[2], 4 bytes of padding, double[4].
+  //   Layout<char, int, double> x(3, 2, 4);
+  //   auto s = x.Stats();
+  //   assert(s.alloc_size == 48 && s.padding_bytes == 5);
+  //   // double[4], int[2], char[3] needs no padding at all.
+  //   assert(s.min_padding_alloc_size == 43 && s.reorder_savings == 5);
+  //
+  // The padding-minimizing order is found by trying all the permutations for
+  // up to 8 fields and by sorting the fields by decreasing alignment (see the
+  // efficiency tip at the top of the file) for more.
+  //
+  // Requires: `NumSizes == sizeof...(Ts)`.
+  LayoutStats<NumTypes> Stats(size_t cache_line_size = kCacheLineSize) const {
+    static_assert(NumTypes == NumSizes, "You must specify sizes of all fields");
+    assert(adl_barrier::IsPow2(cache_line_size) && cache_line_size > 0);
+    const auto offsets = Offsets();
+    // Bit-packed values never straddle a cache line on their own account: we
+    // report 0 for them.
+    const size_t elem_sizes[] = {
+        (BitsPerValue<ElementSpec<OffsetSeq>>::value != 0
+             ? 0
+             : SizeOf<ElementType<OffsetSeq>>())...};
+    const size_t array_bytes[] = {ArrayBytes<OffsetSeq>()...};
+    const std::array<size_t, NumTypes> aligns = {
+        {ElementAlignment<OffsetSeq>::value...}};
+
+    LayoutStats<NumTypes> res;
+    res.cache_line_size = cache_line_size;
+    res.alloc_size = AllocSize();
+    std::array<size_t, NumTypes> bytes;
+    size_t prev_end = 0;
+    for (size_t i = 0; i != NumTypes; ++i) {
+      FieldStats& f = res.fields[i];
+      f.offset = offsets[i];
+      f.bytes = bytes[i] = array_bytes[i];
+      f.padding = f.offset - prev_end;
+      f.cache_lines =
+          adl_barrier::CacheLinesSpanned(f.offset, f.bytes, cache_line_size);
+      f.straddling = adl_barrier::StraddlingCount(f.offset, elem_sizes[i],
+                                                  size_[i], cache_line_size);
+      prev_end = f.offset + f.bytes;
+      res.payload_bytes += f.bytes;
+    }
+    res.padding_bytes = res.alloc_size - res.payload_bytes;
+    res.padding_ratio =
+        res.alloc_size == 0
+            ? 0
+            : static_cast<double>(res.padding_bytes) / res.alloc_size;
+
+    std::array<size_t, NumTypes> order;
+    std::iota(order.begin(), order.end(), size_t{0});
+    if (NumTypes <= 8) {
+      res.min_padding_order = order;
+      res.min_padding_alloc_size = res.alloc_size;
+      while (std::next_permutation(order.begin(), order.end())) {
+        size_t n = adl_barrier::PackedSize(order, bytes, aligns);
+        if (n < res.min_padding_alloc_size) {
+          res.min_padding_alloc_size = n;
+          res.min_padding_order = order;
+        }
+      }
+    } else {
+      std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return aligns[a] > aligns[b];
+      });
+      res.min_padding_order = order;
+      res.min_padding_alloc_size = std::min(
+          res.alloc_size, adl_barrier::PackedSize(order, bytes, aligns));
+    }
+    res.reorder_savings = res.alloc_size - res.min_padding_alloc_size;
+    return res;
+  }
+
+  // Human-readable version of `Stats()`, one line per array. Slow.
+  //
+  //   Layout<char, int, double>(3, 2, 4).Report() ==
+  //       "alignment 8, alloc 48 B, payload 43 B, padding 5 B (10.4%)\n"
+  //       "  #0 <char> @0 3x1 = 3 B, padding 0 B, 1 line(s), 0 straddling\n"
+  //       ...
+  //       "  min-padding order 1 2 0: alloc 43 B, saves 5 B\n"
+  //
+  // Requires: `NumSizes == sizeof...(Ts)`.
+  std::string Report(size_t cache_line_size = kCacheLineSize) const {
+    const auto stats = Stats(cache_line_size);
+    const size_t value_bits[] = {BitsPerValue<ElementSpec<OffsetSeq>>::value...};
+    // Bit-packed arrays show up as "<Bits<K>> ... nxKb".
+    const std::string elem_sizes[] = {
+        (value_bits[OffsetSeq] != 0
+             ? fmt::format("{}b", value_bits[OffsetSeq])
+             : fmt::format("{}", SizeOf<ElementType<OffsetSeq>>()))...};
+    const std::string types[] = {
+        (value_bits[OffsetSeq] != 0
+             ? fmt::format("<Bits<{}>>", value_bits[OffsetSeq])
+             : adl_barrier::TypeName<ElementType<OffsetSeq>>())...};
+    std::string res = fmt::format(
+        "alignment {}, alloc {} B, payload {} B, padding {} B ({:.1f}%)\n",
+        Alignment(), stats.alloc_size, stats.payload_bytes,
+        stats.padding_bytes, stats.padding_ratio * 100);
+    for (size_t i = 0; i != NumTypes; ++i) {
+      const FieldStats& f = stats.fields[i];
+      res += fmt::format(
+          "  #{} {} @{} {}x{} = {} B, padding {} B, {} line(s), {} "
+          "straddling\n",
+          i, types[i], f.offset, size_[i], elem_sizes[i], f.bytes, f.padding,
+          f.cache_lines, f.straddling);
+    }
+    res += "  min-padding order";
+    for (size_t i : stats.min_padding_order) res += fmt::format(" {}", i);
+    res += fmt::format(": alloc {} B, saves {} B\n",
+                       stats.min_padding_alloc_size, stats.reorder_savings);
+    return res;
+  }
+
   // Human-readable description of the memory layout. Useful for debugging.
   // Slow.
   //
@@ -993,6 +1492,26 @@ class LayoutImpl<std::tuple<Elements...>, std::index_sequence<SizeSeq...>,
   }
 
  private:
+  // Stores the end of array `M - 1` (0 if `M == 0`) in `*end`, computed like
+  // `Offset()`. Returns true on overflow.
+  template <size_t M>
+  constexpr bool CheckedEnd(size_t* end) const {
+    bool overflow = false;
+    size_t pos = 0;
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      ((overflow |= adl_barrier::CheckedAlign(pos, ElementAlignment<I>::value,
+                                              &pos),
+        [&] {
+          size_t bytes = 0;
+          overflow |= adl_barrier::CheckedArrayBytes<ElementSpec<I>>(size_[I],
+                                                                    &bytes);
+          overflow |= __builtin_add_overflow(pos, bytes, &pos);
+        }()), ...);
+    }(std::make_index_sequence<M>());
+    *end = pos;
+    return overflow;
+  }
+
   // Arguments of `Layout::Partial()` or `Layout::Layout()`.
   size_t size_[NumSizes > 0 ? NumSizes : 1];
 };
@@ -1123,6 +1642,104 @@ class Layout : public internal_layout::LayoutType<sizeof...(Ts), Ts...> {
       : internal_layout::LayoutType<sizeof...(Ts), Ts...>(sizes...) {}
 };
 
+// `CheckedAllocSize()` of each of the `n` layouts into `sizes[0, n)`, 0 for
+// those that overflow. Returns the number of layouts that overflow, so a batch
+// of untrusted headers costs one branch instead of one per layout.
+template <class L>
+size_t CheckedAllocSizes(const L* layouts, size_t n, size_t* sizes) {
+  size_t overflows = 0;
+  for (size_t i = 0; i != n; ++i) {
+    const std::optional<size_t> size = layouts[i].CheckedAllocSize();
+    overflows += !size.has_value();
+    sizes[i] = size.value_or(0);
+  }
+  return overflows;
+}
+
+// A fixed-size record whose internal layout is described by `L` with the
+// compile-time array sizes `Counts...`. It's a regular type with
+// `alignof == L::Alignment()` and `sizeof == AllocSize()` rounded up to that
+// alignment, so it can itself be an element of another `Layout`, and arrays of
+// it are arrays of sub-records.
+//
+//   // uint32_t[1] id, float[3] xyz, char[1] flag: 20 bytes, aligned to 4.
+//   using Point =
+//       SubLayout<Layout<Field<"id", uint32_t>, float, char>, 1, 3, 1>;
+//   // size_t[1] count, Point[count].
+//   using Message = Layout<size_t, Point>;
+//
+//   const Message layout(1, n);
+//   Point* points = layout.Pointer<1>(p);
+//   float* xyz = points[i].Pointer<1>();   // == p + 8 + i * 20 + 4
+//
+// Offsets inside the record are compile-time constants, so composing the outer
+// `Pointer<N>` with the inner `Pointer<M>` costs the same as a hand-written
+// struct. Like `Layout`, the record doesn't construct its elements; it's just
+// storage.
+template <class L, size_t... Counts>
+struct alignas(L::Alignment()) SubLayout {
+  static_assert(sizeof...(Counts) == L::NumTypes,
+                "You must specify sizes of all fields");
+
+  // The layout of one record.
+  static constexpr L kLayout = L(Counts...);
+  static constexpr size_t kSize =
+      internal_layout::adl_barrier::Align(kLayout.AllocSize(), L::Alignment());
+  static_assert(kSize > 0, "Empty sub-layout");
+
+  template <size_t M>
+  using ElementType = typename L::template ElementType<M>;
+
+  template <size_t M>
+  static constexpr size_t Offset() {
+    return kLayout.template Offset<M>();
+  }
+
+  template <FixedString Name>
+  static constexpr size_t Offset() {
+    return kLayout.template Offset<Name>();
+  }
+
+  template <size_t M>
+  static constexpr size_t Size() {
+    return kLayout.template Size<M>();
+  }
+
+  // Pointer to the beginning of the Mth array of this record.
+  template <size_t M>
+  ElementType<M>* Pointer() {
+    return reinterpret_cast<ElementType<M>*>(bytes_ + Offset<M>());
+  }
+
+  template <size_t M>
+  const ElementType<M>* Pointer() const {
+    return reinterpret_cast<const ElementType<M>*>(bytes_ + Offset<M>());
+  }
+
+  template <FixedString Name>
+  ElementType<L::template NameIndex<Name>()>* Pointer() {
+    return Pointer<L::template NameIndex<Name>()>();
+  }
+
+  template <FixedString Name>
+  const ElementType<L::template NameIndex<Name>()>* Pointer() const {
+    return Pointer<L::template NameIndex<Name>()>();
+  }
+
+  // The Mth array of this record.
+  template <size_t M>
+  typename L::template SliceFor<M, unsigned char> Slice() {
+    return {Pointer<M>(), Size<M>()};
+  }
+
+  template <size_t M>
+  typename L::template SliceFor<M, const unsigned char> Slice() const {
+    return {Pointer<M>(), Size<M>()};
+  }
+
+  unsigned char bytes_[kSize];
+};
+
 }  // namespace container_internal
 }  // namespace absl
 
@@ -0,0 +1,76 @@
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "layout.h"
+
+using namespace absl::container_internal;
+
+// 打印一组注册过的layout的padding和cache line统计；
+//
+// 用法：
+//   ./layout_report            打印全部
+//   ./layout_report foo bar    只打印名字中包含foo或bar的
+//   ./layout_report -l         只列出名字
+//
+// 新的layout在main()开头用Register()加进来即可。
+
+namespace {
+
+struct Entry {
+  std::string name;
+  std::function<std::string()> report;
+};
+
+std::vector<Entry>& Registry() {
+  static std::vector<Entry> registry;
+  return registry;
+}
+
+template <class L, class... Sizes>
+void Register(std::string name, Sizes... sizes) {
+  Registry().push_back(
+      {std::move(name), [=] { return L(sizes...).Report(); }});
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  // test_serialize.cpp中的MyCompactFoo；
+  Register<Layout<size_t, size_t, float, double>>(
+      "MyCompactFoo(3 floats, 4 doubles)", 1, 1, 3, 4);
+  Register<Layout<size_t, size_t, float, double>>(
+      "MyCompactFoo(1000 floats, 1000 doubles)", 1, 1, 1000, 1000);
+
+  // test_alignment.cpp中的两个layout；
+  Register<Layout<char, int, double>>("char[3], int[2], double[4]", 3, 2, 4);
+  Register<Layout<char, Aligned<int, 32>, double>>(
+      "char[3], Aligned<int,32>[2], double[4]", 3, 2, 4);
+
+  // 头部的CompactString；
+  Register<Layout<size_t, char>>("CompactString(\"hello\")", 1, 6);
+
+  // 小类型在前，大类型在后：最差的顺序；
+  Register<Layout<char, short, int, double>>("char, short, int, double x7", 7,
+                                             7, 7, 7);
+
+  if (argc > 1 && strcmp(argv[1], "-l") == 0) {
+    for (const Entry& e : Registry()) std::cout << e.name << std::endl;
+    return 0;
+  }
+
+  for (const Entry& e : Registry()) {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc && !selected; ++i) {
+      selected = e.name.find(argv[i]) != std::string::npos;
+    }
+    if (!selected) continue;
+    std::cout << e.name << ": " << e.report() << std::endl;
+  }
+  return 0;
+}
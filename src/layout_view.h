@@ -0,0 +1,154 @@
+// A validated view of a `Layout` blob received from an untrusted source.
+//
+// `use()` in test_serialize.cpp reads the counts stored in the blob and
+// builds a `Layout` from them. If the blob came from the network or a file,
+// the counts may be garbage, and `AllocSize()` of that layout may exceed the
+// received bytes (or wrap around). `TryView()` validates everything once, in
+// O(number of arrays), so that every access through the view is in bounds
+// without further checks.
+//
+// The blob follows the "counts first" convention of test_serialize.cpp: a
+// layout of `2 * H` arrays whose first `H` arrays hold one unsigned count each,
+// the count of array `i` being stored in array `i - H`.
+//
+//   using L = Layout<size_t, size_t, float, double>;
+//   auto view = TryView<L>(buf, len);
+//   if (!view.valid()) return view.error();  // kTruncated, kMisaligned, ...
+//   for (float f : view.Slice<2>()) ...       // no checks needed
+//
+// The checks, all overflow-safe: `buf` is aligned to `L::Alignment()`, the
+// counts are inside `len` and fit in `size_t`, and each array (with its
+// padding) ends inside `len`.
+
+#ifndef ABSL_CONTAINER_INTERNAL_LAYOUT_VIEW_H_
+#define ABSL_CONTAINER_INTERNAL_LAYOUT_VIEW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+enum class ViewError {
+  kOk,
+  kMisaligned,  // the buffer isn't aligned to `Alignment()` (or is null)
+  kTruncated,   // the counts or the arrays don't fit in the buffer
+  kOverflow,    // the counts are so large that the blob size overflows size_t
+};
+
+// `Char` is `unsigned char` or `const unsigned char`.
+template <class L, class Char>
+class LayoutView {
+ public:
+  static constexpr size_t kNumCounts = L::NumTypes / 2;
+  static_assert(L::NumTypes % 2 == 0,
+                "LayoutView requires one count array per data array");
+
+  LayoutView() = default;
+
+  bool valid() const { return error_ == ViewError::kOk; }
+  ViewError error() const { return error_; }
+
+  // The validated layout; `layout().AllocSize() <= len`.
+  const L& layout() const { return layout_; }
+  Char* data() const { return p_; }
+
+  template <size_t N>
+  size_t Size() const {
+    return layout_.template Size<N>();
+  }
+  template <FixedString Name>
+  size_t Size() const {
+    return layout_.template Size<Name>();
+  }
+
+  template <size_t N>
+  auto Pointer() const {
+    return layout_.template Pointer<N>(p_);
+  }
+  template <FixedString Name>
+  auto Pointer() const {
+    return layout_.template Pointer<Name>(p_);
+  }
+
+  template <size_t N>
+  auto Slice() const {
+    return layout_.template Slice<N>(p_);
+  }
+  template <FixedString Name>
+  auto Slice() const {
+    return layout_.template Slice<Name>(p_);
+  }
+
+ private:
+  template <class L2, class Char2>
+  friend LayoutView<L2, Char2> TryView(Char2* p, size_t len);
+
+  explicit LayoutView(ViewError error) : error_(error) {}
+  LayoutView(const L& layout, Char* p)
+      : layout_(layout), p_(p), error_(ViewError::kOk) {}
+
+  static constexpr L EmptyLayout() {
+    return []<size_t... I>(std::index_sequence<I...>) {
+      return L((I < kNumCounts ? 1 : 0)...);
+    }(std::make_index_sequence<L::NumTypes>());
+  }
+
+  L layout_ = EmptyLayout();
+  Char* p_ = nullptr;
+  ViewError error_ = ViewError::kMisaligned;
+};
+
+// Validates the blob `p[0, len)` and returns a view of it, or a view with
+// `valid() == false` and the reason in `error()`.
+template <class L, class Char>
+LayoutView<L, Char> TryView(Char* p, size_t len) {
+  using View = LayoutView<L, Char>;
+  constexpr size_t H = View::kNumCounts;
+  static_assert(
+      []<size_t... I>(std::index_sequence<I...>) {
+        return (std::is_unsigned_v<typename L::template ElementType<I>> && ...);
+      }(std::make_index_sequence<H>()),
+      "Counts must be unsigned integers");
+  if (p == nullptr || reinterpret_cast<uintptr_t>(p) % L::Alignment() != 0) {
+    return View(ViewError::kMisaligned);
+  }
+  // The counts: `H` arrays of one element each, at fixed offsets.
+  constexpr auto kHeader = []<size_t... I>(std::index_sequence<I...>) {
+    return L::Partial((void(I), size_t{1})...);
+  }(std::make_index_sequence<H>());
+  constexpr size_t kHeaderBytes =
+      kHeader.template Offset<H - 1>() + kHeader.template ArrayBytes<H - 1>();
+  if (len < kHeaderBytes) return View(ViewError::kTruncated);
+
+  uint64_t counts[H];
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    ((counts[I] = *kHeader.template Pointer<I>(p)), ...);
+  }(std::make_index_sequence<H>());
+  // A count that doesn't fit in size_t (on 32-bit targets) would be truncated
+  // to a small one below.
+  for (uint64_t c : counts) {
+    if (c > SIZE_MAX) return View(ViewError::kOverflow);
+  }
+
+  const L layout = [&]<size_t... I>(std::index_sequence<I...>) {
+    return L((I < H ? size_t{1}
+                    : static_cast<size_t>(counts[I < H ? 0 : I - H]))...);
+  }(std::make_index_sequence<L::NumTypes>());
+  // One pass over the arrays with the overflow flags OR-ed together.
+  const std::optional<size_t> size = layout.CheckedAllocSize();
+  if (!size.has_value()) return View(ViewError::kOverflow);
+  if (*size > len) return View(ViewError::kTruncated);
+  return View(layout, p);
+}
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_LAYOUT_VIEW_H_
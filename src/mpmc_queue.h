@@ -0,0 +1,139 @@
+// A bounded lock-free multi-producer/multi-consumer queue with batch
+// operations.
+//
+//   MpmcQueue<unsigned char*> q(1 << 16);
+//
+//   // Producers: blocks allocated from an `Arena`, enqueued in batches.
+//   unsigned char* batch[32];
+//   ...
+//   size_t n = q.EnqueueBatch(batch, 32);  // may enqueue fewer if nearly full
+//
+//   // Consumers.
+//   unsigned char* out[32];
+//   size_t m = q.DequeueBatch(out, 32);    // 0 if empty
+//
+// The algorithm is Dmitry Vyukov's bounded MPMC queue: every cell carries a
+// sequence number that tells whether it's free or full for the current lap,
+// and producers (consumers) claim cells by a CAS on the shared enqueue
+// (dequeue) position. A batch claims up to `n` consecutive cells with a
+// single CAS, so the shared positions are touched once per batch rather than
+// once per element, which is what limits scaling at high thread counts.
+//
+// `T` is meant to be a small handle, e.g. a pointer to a `Layout` block.
+
+#ifndef ABSL_CONTAINER_INTERNAL_MPMC_QUEUE_H_
+#define ABSL_CONTAINER_INTERNAL_MPMC_QUEUE_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+template <class T>
+class MpmcQueue {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>, "T must be a handle");
+
+  // Requires: `capacity` is a power of 2.
+  explicit MpmcQueue(size_t capacity)
+      : cells_(new Cell[capacity]), mask_(capacity - 1) {
+    assert(capacity > 0 && internal_layout::adl_barrier::IsPow2(capacity));
+    for (size_t i = 0; i != capacity; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Enqueues up to `n` items from `items` and returns how many were enqueued:
+  // 0 if the queue is full.
+  size_t EnqueueBatch(const T* items, size_t n) {
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      size_t k = 0;
+      for (; k != n; ++k) {
+        if (cells_[(pos + k) & mask_].seq.load(std::memory_order_acquire) !=
+            pos + k) {
+          break;
+        }
+      }
+      if (k == 0) {
+        uint64_t seq = cells_[pos & mask_].seq.load(std::memory_order_acquire);
+        if (static_cast<int64_t>(seq - pos) < 0) return 0;  // full
+        pos = enqueue_pos_.load(std::memory_order_relaxed);  // lost the race
+        continue;
+      }
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + k,
+                                             std::memory_order_relaxed)) {
+        for (size_t i = 0; i != k; ++i) {
+          Cell& c = cells_[(pos + i) & mask_];
+          c.value = items[i];
+          c.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        return k;
+      }
+    }
+  }
+
+  // Dequeues up to `n` items into `out` and returns how many were dequeued:
+  // 0 if the queue is empty.
+  size_t DequeueBatch(T* out, size_t n) {
+    uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      size_t k = 0;
+      for (; k != n; ++k) {
+        if (cells_[(pos + k) & mask_].seq.load(std::memory_order_acquire) !=
+            pos + k + 1) {
+          break;
+        }
+      }
+      if (k == 0) {
+        uint64_t seq = cells_[pos & mask_].seq.load(std::memory_order_acquire);
+        if (static_cast<int64_t>(seq - (pos + 1)) < 0) return 0;  // empty
+        pos = dequeue_pos_.load(std::memory_order_relaxed);  // lost the race
+        continue;
+      }
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + k,
+                                             std::memory_order_relaxed)) {
+        for (size_t i = 0; i != k; ++i) {
+          Cell& c = cells_[(pos + i) & mask_];
+          out[i] = c.value;
+          c.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+        }
+        return k;
+      }
+    }
+  }
+
+  bool Enqueue(const T& item) { return EnqueueBatch(&item, 1) == 1; }
+  bool Dequeue(T* out) { return DequeueBatch(out, 1) == 1; }
+
+ private:
+  struct Cell {
+    std::atomic<uint64_t> seq;
+    T value;
+  };
+
+  static constexpr size_t kLine = internal_layout::kCacheLineSize;
+
+  const std::unique_ptr<Cell[]> cells_;
+  const size_t mask_;
+  alignas(kLine) std::atomic<uint64_t> enqueue_pos_{0};
+  alignas(kLine) std::atomic<uint64_t> dequeue_pos_{0};
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_MPMC_QUEUE_H_
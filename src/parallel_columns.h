@@ -0,0 +1,369 @@
+// Multi-core algorithms over `Layout` columns.
+//
+//   using L = Layout<uint64_t, double, float>;
+//   const L layout(n, n, n);
+//   ThreadPool pool(16);
+//   auto rows = layout.Zip<0, 1, 2>(p);
+//
+//   ParallelForEach(pool, rows, [](uint64_t& id, double& x, float& y) {...});
+//   ParallelTransform(pool, layout.Zip<0, 1>(p), layout.Pointer<2>(p),
+//                     [](uint64_t id, double x) { return float(id * x); });
+//   double sum = ParallelReduce(pool, layout.Zip<1>(p), 0.0,
+//                               [](double x) { return x; }, std::plus<>());
+//   ParallelSortByKey<0>(pool, rows);         // by id, all columns move
+//   size_t k = ParallelPartition(pool, rows,  // stable; returns the number
+//       [](uint64_t id, double, float) { return id % 2 == 0; });  // of trues
+//
+// The rows are cut into chunks whose size in rows is a multiple of
+// `RowQuantum<Ts...>()`, which makes the byte length of every column's chunk
+// a multiple of the cache-line size. If the columns start on cache lines (for
+// example, declared as `Aligned<T, kCacheLineSize>`), no two chunks share a
+// line of any column, so writers never contend for a line.
+// Chunks hold about `kChunkBytes` of row data, and each worker gets at least
+// four of them.
+//
+// Chunks are scheduled by work stealing on top of `ThreadPool`. Worker `w`
+// starts with a contiguous share of the chunks in its own `WorkStealingDeque`
+// and pops them in order. When its deque runs dry, it steals from the far
+// end of the others' deques. A worker slowed down by page faults or by
+// another process therefore doesn't hold everyone back, and the chunks
+// stay contiguous per worker for prefetching.
+//
+// `ParallelSortByKey()` sorts (key, row) pairs: chunk-wise, then in rounds of
+// merges split by merge path so that each round is fully parallel. It then
+// gathers every column through the permutation. `ParallelPartition()`
+// counts per chunk, scatters into scratch columns at the prefix-summed
+// positions, and copies back. Both use a scratch `Layout` block the size of
+// the rows, and require trivially copyable columns.
+
+#ifndef ABSL_CONTAINER_INTERNAL_PARALLEL_COLUMNS_H_
+#define ABSL_CONTAINER_INTERNAL_PARALLEL_COLUMNS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "layout.h"
+#include "thread_pool.h"
+#include "work_stealing.h"
+#include "zip_range.h"
+
+namespace absl {
+namespace container_internal {
+
+// Rows per chunk are a multiple of this: the smallest number of rows that is
+// a whole number of cache lines in every column.
+template <class... Ts>
+constexpr size_t RowQuantum() {
+  constexpr size_t kLine = internal_layout::kCacheLineSize;
+  size_t q = 1;
+  ((q = std::lcm(q, kLine / std::gcd(kLine, sizeof(Ts)))), ...);
+  return q;
+}
+
+namespace parallel_internal {
+
+inline constexpr size_t kChunkBytes = size_t{128} << 10;
+
+template <class... Ts>
+size_t ChunkRows(size_t n, size_t workers) {
+  constexpr size_t q = RowQuantum<Ts...>();
+  constexpr size_t row_bytes = (sizeof(Ts) + ... + 0);
+  size_t rows = std::max<size_t>(kChunkBytes / row_bytes, 1);
+  // At least four chunks per worker, for stealing.
+  rows = std::min(rows, (n + 4 * workers - 1) / (4 * workers));
+  rows = (rows + q - 1) / q * q;
+  return std::max(rows, q);
+}
+
+inline size_t Pow2AtLeast(size_t n) {
+  size_t c = 1;
+  while (c < n) c *= 2;
+  return c;
+}
+
+// Calls `fn(begin, end)` for consecutive ranges of `chunk` indices covering
+// `[0, n)`, scheduled by work stealing on the workers of `pool`.
+template <class Fn>
+void ForEachChunk(ThreadPool& pool, size_t n, size_t chunk, Fn&& fn) {
+  const size_t num_chunks = (n + chunk - 1) / chunk;
+  const size_t workers = std::min(pool.size(), num_chunks);
+  const auto run = [&](uint64_t c) {
+    fn(c * chunk, std::min(n, (c + 1) * chunk));
+  };
+  if (workers <= 1) {
+    for (uint64_t c = 0; c != num_chunks; ++c) run(c);
+    return;
+  }
+  // The deques are filled before the workers start; `Run()` publishes them.
+  std::vector<std::unique_ptr<WorkStealingDeque<uint64_t>>> deques;
+  for (size_t w = 0; w != workers; ++w) {
+    const uint64_t first = num_chunks * w / workers;
+    const uint64_t last = num_chunks * (w + 1) / workers;
+    deques.emplace_back(
+        new WorkStealingDeque<uint64_t>(Pow2AtLeast(last - first)));
+    // Reversed: the owner pops the share in order, thieves take its end.
+    for (uint64_t c = last; c-- > first;) deques.back()->Push(c);
+  }
+  pool.Run([&](size_t w) {
+    if (w >= workers) return;
+    uint64_t c;
+    for (;;) {
+      if (deques[w]->Pop(&c)) {
+        run(c);
+        continue;
+      }
+      bool stolen = false;
+      for (size_t i = 1; i != workers && !stolen; ++i) {
+        stolen = deques[(w + i) % workers]->Steal(&c);
+      }
+      if (stolen) {
+        run(c);
+        continue;
+      }
+      // `Steal()` may fail spuriously: stop only when everything is taken.
+      bool empty = true;
+      for (const auto& d : deques) empty &= d->size() == 0;
+      if (empty) return;
+    }
+  });
+}
+
+// Columns that can be moved through `Scratch` and `CopyRows()`.
+template <class... Ts>
+constexpr bool Sortable() {
+  return ((!std::is_const_v<Ts> && std::is_trivially_copyable_v<Ts>) && ...);
+}
+
+// Scratch columns for `n` rows of `ZipRange<Ts...>`, in one `Layout` block.
+template <class... Ts>
+class Scratch {
+ public:
+  static constexpr size_t kLine = internal_layout::kCacheLineSize;
+  using L = Layout<
+      Aligned<std::remove_const_t<Ts>, std::max(alignof(Ts), kLine)>...>;
+
+  explicit Scratch(size_t n) : layout_(((void)sizeof(Ts), n)...) {
+    p_ = static_cast<unsigned char*>(::operator new(
+        layout_.AllocSize(), std::align_val_t{L::Alignment()}));
+  }
+  ~Scratch() { ::operator delete(p_, std::align_val_t{L::Alignment()}); }
+
+  Scratch(const Scratch&) = delete;
+  Scratch& operator=(const Scratch&) = delete;
+
+  ZipRange<std::remove_const_t<Ts>...> rows() const {
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+      return layout_.template Zip<I...>(p_);
+    }(std::index_sequence_for<Ts...>());
+  }
+
+ private:
+  const L layout_;
+  unsigned char* p_;
+};
+
+// Copies rows `[begin, end)` of `from` to the same rows of `to`.
+template <class... Ts, class... Us>
+void CopyRows(const ZipRange<Ts...>& from, const ZipRange<Us...>& to,
+              size_t begin, size_t end) {
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    (memcpy(to.template column<I>() + begin, from.template column<I>() + begin,
+            (end - begin) * sizeof(*from.template column<I>())),
+     ...);
+  }(std::index_sequence_for<Ts...>());
+}
+
+// Number of elements of `a` among the first `k` elements of the stable merge
+// of `a` and `b` (the merge path split at diagonal `k`).
+template <class T, class Less>
+size_t MergeSplit(const T* a, size_t na, const T* b, size_t nb, size_t k,
+                  Less less) {
+  size_t lo = k > nb ? k - nb : 0;
+  size_t hi = std::min(k, na);
+  while (lo < hi) {
+    const size_t i = (lo + hi) / 2;
+    // Take `a[i]` among the first `k` unless `b[k - i - 1]` goes before it.
+    if (less(b[k - i - 1], a[i])) {
+      hi = i;
+    } else {
+      lo = i + 1;
+    }
+  }
+  return lo;
+}
+
+template <class Key>
+struct KeyRow {
+  Key key;
+  size_t row;
+};
+
+}  // namespace parallel_internal
+
+// `fn(col0[i], col1[i], ...)` for every row.
+template <class... Ts, class Fn>
+void ParallelForEach(ThreadPool& pool, const ZipRange<Ts...>& rows, Fn fn) {
+  namespace pi = parallel_internal;
+  pi::ForEachChunk(pool, rows.size(),
+                   pi::ChunkRows<Ts...>(rows.size(), pool.size()),
+                   [&](size_t begin, size_t end) {
+                     rows.subrange(begin, end).ForEach(fn);
+                   });
+}
+
+// `out[i] = fn(col0[i], col1[i], ...)` for every row. `out` must not overlap
+// the columns of `rows`; to update a column in place, use `ParallelForEach()`.
+template <class... Ts, class Out, class Fn>
+void ParallelTransform(ThreadPool& pool, const ZipRange<Ts...>& rows, Out* out,
+                       Fn fn) {
+  namespace pi = parallel_internal;
+  const ZipRange<Out, Ts...> all = std::apply(
+      [&](Ts*... cols) {
+        return ZipRange<Out, Ts...>(rows.size(), out, cols...);
+      },
+      rows.columns());
+  pi::ForEachChunk(pool, rows.size(),
+                   pi::ChunkRows<Out, Ts...>(rows.size(), pool.size()),
+                   [&](size_t begin, size_t end) {
+                     all.subrange(begin, end).ForEach(
+                         [&](Out& o, Ts&... x) { o = fn(x...); });
+                   });
+}
+
+// `init` combined with `map(row)` of every row, in row order but grouped by
+// chunk, so `combine` must be associative. The grouping, and therefore the
+// result, doesn't depend on the number of workers.
+template <class... Ts, class T, class Map, class Combine>
+T ParallelReduce(ThreadPool& pool, const ZipRange<Ts...>& rows, T init, Map map,
+                 Combine combine) {
+  namespace pi = parallel_internal;
+  // Chunks don't depend on the pool, so neither does the grouping.
+  const size_t chunk = pi::ChunkRows<Ts...>(rows.size(), 1);
+  const size_t num_chunks = (rows.size() + chunk - 1) / chunk;
+  std::vector<T> partial(num_chunks, init);
+  pi::ForEachChunk(pool, rows.size(), chunk, [&](size_t begin, size_t end) {
+    T acc = std::apply([&](Ts*... cols) { return map(cols[begin]...); },
+                       rows.columns());
+    rows.subrange(begin + 1, end).ForEach(
+        [&](Ts&... x) { acc = combine(acc, map(x...)); });
+    partial[begin / chunk] = acc;
+  });
+  T result = init;
+  for (const T& x : partial) result = combine(result, x);
+  return result;
+}
+
+// Sorts the rows by column `K`, moving all columns together. Stable.
+template <size_t K, class... Ts, class Less = std::less<>>
+void ParallelSortByKey(ThreadPool& pool, const ZipRange<Ts...>& rows,
+                       Less less = Less()) {
+  namespace pi = parallel_internal;
+  static_assert(pi::Sortable<Ts...>(), "columns must be trivially copyable");
+  using Key = std::remove_const_t<
+      std::remove_pointer_t<decltype(rows.template column<K>())>>;
+  using KR = pi::KeyRow<Key>;
+  const size_t n = rows.size();
+  if (n < 2) return;
+  // Ties keep the row order.
+  const auto kr_less = [&](const KR& x, const KR& y) {
+    return less(x.key, y.key) || (!less(y.key, x.key) && x.row < y.row);
+  };
+
+  std::unique_ptr<KR[]> a(new KR[n]);
+  std::unique_ptr<KR[]> b(new KR[n]);
+  const Key* keys = rows.template column<K>();
+  const size_t chunk = pi::ChunkRows<KR>(n, pool.size());
+  pi::ForEachChunk(pool, n, chunk, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i != end; ++i) a[i] = KR{keys[i], i};
+    std::sort(a.get() + begin, a.get() + end, kr_less);
+  });
+  // Merge sorted runs of `w` pairwise. `2 * w` is a multiple of `chunk`, so
+  // each output chunk lies inside one merge: split it off by merge path.
+  for (size_t w = chunk; w < n; w *= 2) {
+    pi::ForEachChunk(pool, n, chunk, [&](size_t begin, size_t end) {
+      const size_t lo = begin / (2 * w) * (2 * w);
+      const size_t mid = std::min(lo + w, n);
+      const size_t hi = std::min(lo + 2 * w, n);
+      const KR* x = a.get() + lo;
+      const KR* y = a.get() + mid;
+      const size_t k0 = begin - lo, k1 = end - lo;
+      const size_t i0 = pi::MergeSplit(x, mid - lo, y, hi - mid, k0, kr_less);
+      const size_t i1 = pi::MergeSplit(x, mid - lo, y, hi - mid, k1, kr_less);
+      std::merge(x + i0, x + i1, y + (k0 - i0), y + (k1 - i1), b.get() + begin,
+                 kr_less);
+    });
+    std::swap(a, b);
+  }
+
+  // Gather every column through the permutation, then copy back.
+  const pi::Scratch<Ts...> scratch(n);
+  const auto tmp = scratch.rows();
+  const size_t row_chunk = pi::ChunkRows<Ts...>(n, pool.size());
+  pi::ForEachChunk(pool, n, row_chunk, [&](size_t begin, size_t end) {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      for (size_t i = begin; i != end; ++i) {
+        const size_t from = a[i].row;
+        ((tmp.template column<I>()[i] = rows.template column<I>()[from]), ...);
+      }
+    }(std::index_sequence_for<Ts...>());
+  });
+  pi::ForEachChunk(pool, n, row_chunk, [&](size_t begin, size_t end) {
+    pi::CopyRows(tmp, rows, begin, end);
+  });
+}
+
+// Moves the rows for which `pred(col0[i], col1[i], ...)` is true before the
+// others, keeping the order within both groups, and returns their number.
+// `pred` is called twice per row.
+template <class... Ts, class Pred>
+size_t ParallelPartition(ThreadPool& pool, const ZipRange<Ts...>& rows,
+                         Pred pred) {
+  namespace pi = parallel_internal;
+  static_assert(pi::Sortable<Ts...>(), "columns must be trivially copyable");
+  const size_t n = rows.size();
+  const size_t chunk = pi::ChunkRows<Ts...>(n, pool.size());
+  const size_t num_chunks = (n + chunk - 1) / chunk;
+  std::vector<size_t> trues(num_chunks + 1);
+  pi::ForEachChunk(pool, n, chunk, [&](size_t begin, size_t end) {
+    size_t count = 0;
+    rows.subrange(begin, end).ForEach(
+        [&](Ts&... x) { count += pred(x...) ? 1 : 0; });
+    trues[begin / chunk + 1] = count;
+  });
+  std::partial_sum(trues.begin(), trues.end(), trues.begin());
+  const size_t total = trues[num_chunks];
+
+  const pi::Scratch<Ts...> scratch(n);
+  const auto tmp = scratch.rows();
+  pi::ForEachChunk(pool, n, chunk, [&](size_t begin, size_t end) {
+    const size_t c = begin / chunk;
+    size_t t = trues[c];
+    size_t f = total + begin - trues[c];
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      for (size_t i = begin; i != end; ++i) {
+        const size_t to = pred(rows.template column<I>()[i]...) ? t++ : f++;
+        ((tmp.template column<I>()[to] = rows.template column<I>()[i]), ...);
+      }
+    }(std::index_sequence_for<Ts...>());
+  });
+  pi::ForEachChunk(pool, n, chunk, [&](size_t begin, size_t end) {
+    pi::CopyRows(tmp, rows, begin, end);
+  });
+  return total;
+}
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_PARALLEL_COLUMNS_H_
@@ -0,0 +1,178 @@
+// Lightweight hardware performance counters for benchmark regions.
+//
+//   PerfCounters counters;
+//   counters.Start();
+//   ... code under test ...
+//   PerfSample s = counters.Stop();
+//   if (s.Valid(PerfCounters::kL1DMisses)) {
+//     double per_elem = s.PerElement(PerfCounters::kL1DMisses, n);
+//   }
+//
+// On Linux the counters are backed by perf_event_open(2), one file descriptor
+// per event, counting user space of the calling thread only. Every event is
+// opened independently: if the kernel, the PMU or the sandbox (for example
+// `kernel.perf_event_paranoid`, seccomp, containers, VMs without vPMU) refuses
+// one of them, that event is simply reported as not valid and the others keep
+// working. On other platforms everything is a no-op, so benchmarks can use the
+// class unconditionally.
+//
+// Wall-clock numbers alone don't tell whether a layout is cache friendly; the
+// miss counters do. Typical use is to divide them by the number of elements
+// scanned (see bench_layout.cpp).
+
+#ifndef ABSL_CONTAINER_INTERNAL_PERF_COUNTER_H_
+#define ABSL_CONTAINER_INTERNAL_PERF_COUNTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <array>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace absl {
+namespace container_internal {
+
+class PerfCounters;
+
+// Counter values of one measured region. Values are already scaled for
+// multiplexing (when the kernel had to time-share the PMU between events).
+struct PerfSample {
+  // One per `PerfCounters::Event`; checked below `PerfCounters`.
+  static constexpr size_t kNumEvents = 5;
+
+  std::array<uint64_t, kNumEvents> value{};
+  std::array<bool, kNumEvents> valid{};
+
+  bool Valid(size_t event) const { return valid[event]; }
+
+  // `value / n` or -1 if the event is not available.
+  double PerElement(size_t event, size_t n) const {
+    if (!valid[event] || n == 0) return -1;
+    return static_cast<double>(value[event]) / static_cast<double>(n);
+  }
+};
+
+class PerfCounters {
+ public:
+  enum Event : size_t {
+    kCycles = 0,
+    kInstructions,
+    kL1DMisses,
+    kLLCMisses,
+    kDTLBMisses,
+    kNumEvents,
+  };
+
+  static const char* Name(size_t event) {
+    static const char* const kNames[kNumEvents] = {
+        "cycles", "instructions", "L1D-misses", "LLC-misses", "dTLB-misses"};
+    return event < kNumEvents ? kNames[event] : "?";
+  }
+
+  PerfCounters() {
+    fd_.fill(-1);
+#if defined(__linux__)
+    constexpr uint64_t kCacheRead =
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    fd_[kCycles] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fd_[kInstructions] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fd_[kL1DMisses] =
+        Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | kCacheRead);
+    fd_[kLLCMisses] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fd_[kDTLBMisses] =
+        Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | kCacheRead);
+#endif
+  }
+
+  ~PerfCounters() {
+#if defined(__linux__)
+    for (int fd : fd_) {
+      if (fd >= 0) close(fd);
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // True if at least one event could be opened.
+  bool Available() const {
+    for (int fd : fd_) {
+      if (fd >= 0) return true;
+    }
+    return false;
+  }
+
+  bool Available(size_t event) const { return fd_[event] >= 0; }
+
+  // Resets and enables all available counters.
+  void Start() {
+#if defined(__linux__)
+    for (int fd : fd_) {
+      if (fd < 0) continue;
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  // Disables the counters and returns what they counted since `Start()`.
+  PerfSample Stop() {
+    PerfSample s;
+#if defined(__linux__)
+    for (size_t i = 0; i != kNumEvents; ++i) {
+      if (fd_[i] >= 0) ioctl(fd_[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (size_t i = 0; i != kNumEvents; ++i) {
+      if (fd_[i] < 0) continue;
+      // PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+      uint64_t buf[3] = {0, 0, 0};
+      if (read(fd_[i], buf, sizeof(buf)) != sizeof(buf)) continue;
+      if (buf[2] == 0) continue;  // never scheduled on the PMU
+      s.value[i] = buf[2] == buf[1]
+                       ? buf[0]
+                       : static_cast<uint64_t>(static_cast<double>(buf[0]) *
+                                               buf[1] / buf[2]);
+      s.valid[i] = true;
+    }
+#endif
+    return s;
+  }
+
+ private:
+#if defined(__linux__)
+  static int Open(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    long fd = syscall(__NR_perf_event_open, &attr, 0 /*this thread*/,
+                      -1 /*any cpu*/, -1 /*no group*/, 0);
+    return fd < 0 ? -1 : static_cast<int>(fd);
+  }
+#endif
+
+  std::array<int, kNumEvents> fd_;
+};
+
+static_assert(PerfSample::kNumEvents == PerfCounters::kNumEvents,
+              "PerfSample needs one value per PerfCounters::Event");
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_PERF_COUNTER_H_
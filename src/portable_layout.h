@@ -0,0 +1,251 @@
+// A `Layout` block format that reads the same on every host.
+//
+// The block built by `create()` in test_serialize.cpp is only meaningful to a
+// host with the same ABI: the counts are native `size_t`, the numbers are in
+// native byte order and the padding between arrays follows the host's
+// `alignof` (e.g. `alignof(double)` is 4 on i386). `PortableLayout<Ts...>`
+// fixes all three:
+//
+//   - the block starts with a header of little-endian `uint64_t` words:
+//     a magic/version word, then one count per array;
+//   - every array is aligned to the size of its element (`Aligned<T,
+//     sizeof(T)>`), `Bits<K>` to 8, independently of the host;
+//   - all values are stored little-endian.
+//
+//   using P = PortableLayout<uint64_t, float, double>;
+//   std::vector<uint64_t> ids = ...; std::vector<float> f = ...; ...
+//   unsigned char* p = (unsigned char*)aligned_alloc_posix(
+//       P::Alignment(), P::AllocSize(ids.size(), f.size(), d.size()));
+//   P::Build(p, ids, f, d);
+//   ... write to a file / socket; read back on any host ...
+//   P view(p);
+//   if (!view.valid()) ...
+//   for (float x : view.Slice<1>()) ...   // zero-copy on little-endian hosts
+//   view.Load<1>(out);                    // copy; swaps on big-endian hosts
+//
+// On little-endian hosts (x86, ARM) writing is a `memcpy` per array and
+// reading is zero-copy, exactly like the native format. Only big-endian hosts
+// pay for byte swapping, which `ByteSwap()` does 16 bytes at a time with a
+// byte shuffle where the ISA has one (`pshufb`), so the code is exercised on
+// x86 too.
+//
+// Element types must be fixed-width integers, IEEE-754 `float`/`double`,
+// enums, or `Bits<K>`.
+
+#ifndef ABSL_CONTAINER_INTERNAL_PORTABLE_LAYOUT_H_
+#define ABSL_CONTAINER_INTERNAL_PORTABLE_LAYOUT_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <bit>
+#include <limits>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+namespace portable_layout_internal {
+
+// How an element type is declared in the portable `Layout`.
+template <class T>
+struct PortableElement {
+  static_assert(std::is_integral_v<T> || std::is_enum_v<T> ||
+                    (std::is_floating_point_v<T> &&
+                     std::numeric_limits<T>::is_iec559),
+                "PortableLayout supports integers, enums, IEEE-754 floating "
+                "point and Bits<K>");
+  static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+                    sizeof(T) == 8,
+                "PortableLayout elements must be 1, 2, 4 or 8 bytes");
+  using type = Aligned<T, sizeof(T)>;
+};
+
+template <size_t K>
+struct PortableElement<Bits<K>> {
+  using type = Bits<K>;
+};
+
+inline uint16_t Swap(uint16_t v) { return __builtin_bswap16(v); }
+inline uint32_t Swap(uint32_t v) { return __builtin_bswap32(v); }
+inline uint64_t Swap(uint64_t v) { return __builtin_bswap64(v); }
+
+template <size_t Size>
+using Word = std::conditional_t<
+    Size == 2, uint16_t, std::conditional_t<Size == 4, uint32_t, uint64_t>>;
+
+#if defined(__x86_64__)
+// Byte `i` of every 16-byte block comes from byte `shuffle[i]`.
+template <size_t Size>
+__attribute__((target("ssse3"))) size_t ByteSwapSsse3(unsigned char* dst,
+                                                      const unsigned char* src,
+                                                      size_t bytes) {
+  alignas(16) unsigned char shuffle[16];
+  for (size_t i = 0; i != 16; ++i) {
+    shuffle[i] = static_cast<unsigned char>(i / Size * Size + Size - 1 -
+                                            i % Size);
+  }
+  const __m128i mask = _mm_load_si128(reinterpret_cast<__m128i*>(shuffle));
+  size_t i = 0;
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_shuffle_epi8(v, mask));
+  }
+  return i;
+}
+
+inline bool HasSsse3() {
+  static const bool kHas = __builtin_cpu_supports("ssse3");
+  return kHas;
+}
+#endif
+
+}  // namespace portable_layout_internal
+
+// Reverses the bytes of each of the `n` elements of `Size` bytes at `src` and
+// writes them to `dst`. `dst == src` is allowed; otherwise they must not
+// overlap.
+template <size_t Size>
+void ByteSwap(void* dst, const void* src, size_t n) {
+  namespace pi = portable_layout_internal;
+  static_assert(Size == 1 || Size == 2 || Size == 4 || Size == 8);
+  unsigned char* d = static_cast<unsigned char*>(dst);
+  const unsigned char* s = static_cast<const unsigned char*>(src);
+  if constexpr (Size == 1) {
+    if (d != s) memmove(d, s, n);
+  } else {
+    size_t done = 0;
+#if defined(__x86_64__)
+    if (pi::HasSsse3()) done = pi::ByteSwapSsse3<Size>(d, s, n * Size);
+#endif
+    for (; done != n * Size; done += Size) {
+      pi::Word<Size> v;
+      memcpy(&v, s + done, Size);
+      v = pi::Swap(v);
+      memcpy(d + done, &v, Size);
+    }
+  }
+}
+
+// Copies `n` elements of `Size` bytes from host to little-endian order (or
+// back; it's the same operation).
+template <size_t Size>
+void CopyLittleEndian(void* dst, const void* src, size_t n) {
+  if constexpr (std::endian::native == std::endian::little || Size == 1) {
+    if (n != 0) memcpy(dst, src, n * Size);
+  } else {
+    ByteSwap<Size>(dst, src, n);
+  }
+}
+
+template <class... Ts>
+class PortableLayout {
+ public:
+  static constexpr size_t kNumArrays = sizeof...(Ts);
+  // "PLYT", then the format version.
+  static constexpr uint32_t kMagic = 0x54594c50;
+  static constexpr uint32_t kVersion = 1;
+
+  // Array 0 is the header: the magic word followed by the counts of arrays
+  // `1..kNumArrays`, all little-endian.
+  using L = Layout<Aligned<uint64_t, 8>,
+                   typename portable_layout_internal::PortableElement<
+                       Ts>::type...>;
+
+  static constexpr size_t Alignment() { return L::Alignment(); }
+
+  static constexpr L MakeLayout(internal_layout::TypeToSize<Ts>... counts) {
+    return L(1 + kNumArrays, counts...);
+  }
+
+  static constexpr size_t AllocSize(internal_layout::TypeToSize<Ts>... counts) {
+    return MakeLayout(counts...).AllocSize();
+  }
+
+  // Writes the block for `arrays` into `p`. Each argument has `data()` and
+  // `size()` (e.g. `std::vector<T>`); for a `Bits<K>` array it's the values'
+  // count and the packed words.
+  //
+  // Requires: `p` is aligned to `Alignment()` and points to
+  // `AllocSize(arrays.size()...)` bytes.
+  template <class... Arrays>
+  static void Build(unsigned char* p, const Arrays&... arrays) {
+    static_assert(sizeof...(Arrays) == kNumArrays, "One array per element");
+    const L layout = MakeLayout(arrays.size()...);
+    const uint64_t header[] = {uint64_t{kVersion} << 32 | kMagic,
+                               uint64_t{arrays.size()}...};
+    CopyLittleEndian<8>(layout.template Pointer<0>(p), header,
+                        1 + kNumArrays);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (Store<I + 1>(layout, p, arrays.data()), ...);
+    }(std::make_index_sequence<kNumArrays>());
+  }
+
+  // A view of the block at `p`. Reads the header only.
+  //
+  // Requires: `p` is aligned to `Alignment()`.
+  explicit PortableLayout(const unsigned char* p) : p_(p) {
+    uint64_t header[1 + kNumArrays];
+    CopyLittleEndian<8>(header, p, 1 + kNumArrays);
+    valid_ = header[0] == (uint64_t{kVersion} << 32 | kMagic);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      layout_ = MakeLayout((valid_ ? header[I + 1] : 0)...);
+    }(std::make_index_sequence<kNumArrays>());
+  }
+
+  // False if the block doesn't start with the magic word of this version.
+  bool valid() const { return valid_; }
+
+  const L& layout() const { return layout_; }
+  size_t AllocSize() const { return layout_.AllocSize(); }
+
+  // Number of elements of array `N` (values for `Bits<K>`).
+  template <size_t N>
+  size_t Size() const {
+    return layout_.template Size<N + 1>();
+  }
+
+  // Array `N`, in place. Only on little-endian hosts; use `Load()` otherwise.
+  template <size_t N>
+  auto Slice() const {
+    static_assert(std::endian::native == std::endian::little,
+                  "Slice() is zero-copy only on little-endian hosts");
+    return layout_.template Slice<N + 1>(p_);
+  }
+
+  // Copies array `N` to `dst` in host byte order. `dst` has room for
+  // `Size<N>()` elements (the packed words for `Bits<K>`).
+  template <size_t N>
+  void Load(typename L::template ElementType<N + 1>* dst) const {
+    using T = typename L::template ElementType<N + 1>;
+    CopyLittleEndian<sizeof(T)>(dst, layout_.template Pointer<N + 1>(p_),
+                                layout_.template ArrayBytes<N + 1>() /
+                                    sizeof(T));
+  }
+
+ private:
+  template <size_t N>
+  static void Store(const L& layout, unsigned char* p,
+                    const typename L::template ElementType<N>* src) {
+    using T = typename L::template ElementType<N>;
+    CopyLittleEndian<sizeof(T)>(layout.template Pointer<N>(p), src,
+                                layout.template ArrayBytes<N>() / sizeof(T));
+  }
+
+  const unsigned char* p_;
+  L layout_ = MakeLayout((internal_layout::TypeToSize<Ts>(0))...);
+  bool valid_ = false;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_PORTABLE_LAYOUT_H_
@@ -0,0 +1,280 @@
+// LSD radix sort of `Layout` rows by one column, moving all columns together.
+//
+//   using L = Layout<uint64_t, double, float>;
+//   const L layout(n, n, n);
+//   auto rows = layout.Zip<0, 1, 2>(p);
+//
+//   RadixSortByKey<0>(rows);                  // by id, all columns move
+//   ThreadPool pool(16);
+//   ParallelRadixSortByKey<0>(pool, rows);    // the same, on 16 workers
+//
+// Keys are integers or floating-point numbers, sorted ascending; the sort is
+// stable. Floating-point keys are ordered by their bits: -0.0 goes before
+// 0.0, and NaNs go to the ends according to their sign.
+//
+// Each pass sorts by the next 8-bit digit of the key, least significant
+// first, and scatters every column from one copy of the rows to the other
+// (the rows and a scratch `Layout` block, alternately). A pass in which all
+// keys have the same digit is skipped, so 64-bit keys with small values cost
+// only as many passes as they have significant bytes. If the number of
+// passes is odd, the rows are copied back at the end.
+//
+// Scattering straight to the destination would keep 256 write streams per
+// column open, far more lines than L1 holds. Instead, rows are staged per
+// digit in a `WriteCombiner`: `RowQuantum<Ts...>()` rows per digit, which is
+// a whole number of cache lines in every column. A digit's rows are flushed
+// when its buffer fills, with one `memcpy` per column. Flushes fall on
+// multiples of that many rows, so if the columns start on cache lines (the
+// scratch block's always do), each flush writes complete lines. The
+// buffers take `256 * RowQuantum<Ts...>()` rows (80 KiB for three columns of
+// 8, 8 and 4 bytes) and stay in L2.
+//
+// The parallel version gives each worker a contiguous share of the rows and
+// its own buffers. Per pass, the workers count their digits, the counts are
+// prefix-summed in (digit, worker) order, and each worker scatters its
+// share to its own ranges of the destination. This keeps the sort stable.
+//
+// The columns must be trivially copyable.
+
+#ifndef ABSL_CONTAINER_INTERNAL_RADIX_SORT_H_
+#define ABSL_CONTAINER_INTERNAL_RADIX_SORT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "layout.h"
+#include "parallel_columns.h"
+#include "thread_pool.h"
+#include "zip_range.h"
+
+namespace absl {
+namespace container_internal {
+namespace radix_internal {
+
+inline constexpr size_t kDigitBits = 8;
+inline constexpr size_t kDigits = size_t{1} << kDigitBits;
+
+// `key` as an unsigned integer of the same size and the same order.
+template <class Key>
+auto RadixBits(Key key) {
+  static_assert(std::is_arithmetic_v<Key>, "radix keys are numbers");
+  if constexpr (std::is_floating_point_v<Key>) {
+    static_assert(sizeof(Key) == 4 || sizeof(Key) == 8, "IEEE float or double");
+    using U = std::conditional_t<sizeof(Key) == 4, uint32_t, uint64_t>;
+    constexpr U kSign = U{1} << (8 * sizeof(U) - 1);
+    U u;
+    memcpy(&u, &key, sizeof(u));
+    // Negatives in reverse order below the positives.
+    return (u & kSign) ? static_cast<U>(~u) : static_cast<U>(u | kSign);
+  } else {
+    using U = std::make_unsigned_t<Key>;
+    constexpr U kSign = std::is_signed_v<Key> ? U{1} << (8 * sizeof(U) - 1) : 0;
+    return static_cast<U>(static_cast<U>(key) ^ kSign);
+  }
+}
+
+// Number of rows of each digit.
+struct alignas(internal_layout::kCacheLineSize) Histogram {
+  size_t count[kDigits];
+};
+
+// Per-digit staging buffers for scattering rows of `ZipRange<Ts...>`.
+template <class... Ts>
+class WriteCombiner {
+ public:
+  // Rows per digit: a whole number of cache lines in every column.
+  static constexpr size_t kRows = RowQuantum<Ts...>();
+
+  WriteCombiner() : buf_(kDigits * kRows), rows_(buf_.rows()) {}
+
+  // Moves rows `[begin, end)` of `src` to `dst`. Row `i` goes to row
+  // `next[digit(i)]++` of `dst`.
+  template <class Digit>
+  void Scatter(const ZipRange<Ts...>& src, const ZipRange<Ts...>& dst,
+               size_t begin, size_t end, size_t* next, Digit digit) {
+    // Flushes must not write below a digit's first row: those rows belong to
+    // the previous digit, or to another worker.
+    size_t first[kDigits];
+    std::copy(next, next + kDigits, first);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      for (size_t i = begin; i != end; ++i) {
+        const size_t d = digit(i);
+        const size_t to = next[d]++;
+        const size_t slot = d * kRows + to % kRows;
+        ((rows_.template column<I>()[slot] = src.template column<I>()[i]),
+         ...);
+        if ((to + 1) % kRows != 0) continue;
+        if (to + 1 - kRows >= first[d]) {
+          // A full buffer: constant-size copies the compiler inlines.
+          (memcpy(dst.template column<I>() + (to + 1 - kRows),
+                  rows_.template column<I>() + d * kRows,
+                  kRows * sizeof(*dst.template column<I>())),
+           ...);
+        } else {
+          Flush(dst, d, first[d], to + 1);
+        }
+      }
+    }(std::index_sequence_for<Ts...>());
+    for (size_t d = 0; d != kDigits; ++d) {
+      const size_t tail = next[d] % kRows;
+      if (tail != 0) Flush(dst, d, std::max(first[d], next[d] - tail), next[d]);
+    }
+  }
+
+ private:
+  // Copies the staged rows `[from, to)` of digit `d` to `dst`.
+  void Flush(const ZipRange<Ts...>& dst, size_t d, size_t from, size_t to) {
+    const size_t slot = d * kRows + from % kRows;
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (memcpy(dst.template column<I>() + from,
+              rows_.template column<I>() + slot,
+              (to - from) * sizeof(*dst.template column<I>())),
+       ...);
+    }(std::index_sequence_for<Ts...>());
+  }
+
+  const parallel_internal::Scratch<Ts...> buf_;
+  const ZipRange<Ts...> rows_;
+};
+
+template <size_t K, class... Ts>
+using KeyOf = std::remove_pointer_t<
+    decltype(std::declval<const ZipRange<Ts...>&>().template column<K>())>;
+
+// Digit `pass` of the key of row `i`.
+template <size_t K, class... Ts>
+auto DigitOf(const ZipRange<Ts...>& rows, size_t pass) {
+  const auto* keys = rows.template column<K>();
+  const size_t shift = pass * kDigitBits;
+  return [keys, shift](size_t i) {
+    return static_cast<size_t>((RadixBits(keys[i]) >> shift) & (kDigits - 1));
+  };
+}
+
+}  // namespace radix_internal
+
+// Sorts the rows by column `K`, moving all columns together. Stable.
+template <size_t K, class... Ts>
+void RadixSortByKey(const ZipRange<Ts...>& rows) {
+  namespace ri = radix_internal;
+  static_assert(parallel_internal::Sortable<Ts...>(),
+                "columns must be trivially copyable");
+  using Key = ri::KeyOf<K, Ts...>;
+  constexpr size_t kPasses = sizeof(ri::RadixBits(Key{}));
+  const size_t n = rows.size();
+  if (n < 2) return;
+
+  // All digits of all passes in one read of the keys.
+  std::vector<ri::Histogram> hist(kPasses, ri::Histogram{});
+  const Key* keys = rows.template column<K>();
+  for (size_t i = 0; i != n; ++i) {
+    const auto u = ri::RadixBits(keys[i]);
+    for (size_t pass = 0; pass != kPasses; ++pass) {
+      ++hist[pass].count[(u >> (pass * ri::kDigitBits)) & (ri::kDigits - 1)];
+    }
+  }
+  std::vector<size_t> passes;
+  for (size_t pass = 0; pass != kPasses; ++pass) {
+    const size_t* c = hist[pass].count;
+    if (std::find(c, c + ri::kDigits, n) == c + ri::kDigits) {
+      passes.push_back(pass);
+    }
+  }
+  if (passes.empty()) return;
+
+  const parallel_internal::Scratch<Ts...> scratch(n);
+  ri::WriteCombiner<Ts...> combiner;
+  ZipRange<Ts...> src = rows;
+  ZipRange<Ts...> dst = scratch.rows();
+  for (size_t pass : passes) {
+    size_t next[ri::kDigits];
+    size_t sum = 0;
+    for (size_t d = 0; d != ri::kDigits; ++d) {
+      next[d] = sum;
+      sum += hist[pass].count[d];
+    }
+    combiner.Scatter(src, dst, 0, n, next, ri::DigitOf<K>(src, pass));
+    std::swap(src, dst);
+  }
+  if (passes.size() % 2 != 0) parallel_internal::CopyRows(src, rows, 0, n);
+}
+
+// `RadixSortByKey<K>(rows)` on the workers of `pool`.
+template <size_t K, class... Ts>
+void ParallelRadixSortByKey(ThreadPool& pool, const ZipRange<Ts...>& rows) {
+  namespace pi = parallel_internal;
+  namespace ri = radix_internal;
+  static_assert(pi::Sortable<Ts...>(), "columns must be trivially copyable");
+  using Key = ri::KeyOf<K, Ts...>;
+  using Combiner = ri::WriteCombiner<Ts...>;
+  constexpr size_t kPasses = sizeof(ri::RadixBits(Key{}));
+  const size_t n = rows.size();
+  // A share smaller than the staging buffers isn't worth a worker.
+  const size_t workers = std::clamp<size_t>(
+      n / (ri::kDigits * Combiner::kRows), 1, pool.size());
+  if (workers == 1) return RadixSortByKey<K>(rows);
+
+  // Shares start on a `RowQuantum` boundary, so workers read whole lines.
+  std::vector<size_t> bound(workers + 1);
+  for (size_t w = 0; w != workers; ++w) {
+    bound[w] = n * w / workers / Combiner::kRows * Combiner::kRows;
+  }
+  bound[workers] = n;
+
+  // Each worker allocates, and so first touches, its own buffers.
+  std::vector<std::unique_ptr<Combiner>> combiners(workers);
+  std::vector<ri::Histogram> hist(workers);
+  const pi::Scratch<Ts...> scratch(n);
+  ZipRange<Ts...> src = rows;
+  ZipRange<Ts...> dst = scratch.rows();
+  size_t done = 0;
+  for (size_t pass = 0; pass != kPasses; ++pass) {
+    const auto digit = ri::DigitOf<K>(src, pass);
+    pool.Run([&](size_t w) {
+      if (w >= workers) return;
+      if (!combiners[w]) combiners[w].reset(new Combiner);
+      size_t* c = hist[w].count;
+      std::fill(c, c + ri::kDigits, 0);
+      for (size_t i = bound[w]; i != bound[w + 1]; ++i) ++c[digit(i)];
+    });
+    // Destination of each (digit, worker), in that order. Skip the pass if
+    // one digit has every row.
+    bool skip = false;
+    size_t sum = 0;
+    for (size_t d = 0; d != ri::kDigits; ++d) {
+      const size_t start = sum;
+      for (size_t w = 0; w != workers; ++w) {
+        const size_t count = hist[w].count[d];
+        hist[w].count[d] = sum;
+        sum += count;
+      }
+      skip |= sum - start == n;
+    }
+    if (skip) continue;
+    pool.Run([&](size_t w) {
+      if (w >= workers) return;
+      combiners[w]->Scatter(src, dst, bound[w], bound[w + 1], hist[w].count,
+                            digit);
+    });
+    std::swap(src, dst);
+    ++done;
+  }
+  if (done % 2 != 0) {
+    pi::ForEachChunk(pool, n, pi::ChunkRows<Ts...>(n, pool.size()),
+                     [&](size_t begin, size_t end) {
+                       pi::CopyRows(src, rows, begin, end);
+                     });
+  }
+}
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_RADIX_SORT_H_
@@ -0,0 +1,92 @@
+// A pointer that stores the distance from its own address to the target
+// (a.k.a. offset_ptr).
+//
+// A blob in shared memory may be mapped at a different address in every
+// process. Absolute pointers stored inside it are only valid in the process
+// that wrote them; a `RelativePtr` is valid in every process as long as the
+// pointer and its target are in the same mapping. It's a legal `Layout`
+// element type, so cross-blob references can live inside the blobs:
+//
+//   // size_t[1], RelativePtr<const char>[n]: n references to strings stored
+//   // elsewhere in the same segment.
+//   using L = Layout<size_t, RelativePtr<const char>>;
+//   const L layout(1, n);
+//   RelativePtr<const char>* names = layout.Pointer<1>(p);
+//   names[0] = some_string_in_segment;
+//   ...
+//   const char* s = names[0].get();   // in any process that maps the segment
+//
+// A zero offset means null, so zero-filled memory holds null pointers (a
+// pointer to itself cannot be represented, which is never useful). Copying a
+// `RelativePtr` rebases it: the copy points to the same target. Copying the
+// bytes (memcpy) only preserves the target if the target is moved together
+// with the pointer, e.g. when a whole segment is mapped elsewhere.
+
+#ifndef ABSL_CONTAINER_INTERNAL_RELATIVE_PTR_H_
+#define ABSL_CONTAINER_INTERNAL_RELATIVE_PTR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstddef>
+
+namespace absl {
+namespace container_internal {
+
+template <class T>
+class RelativePtr {
+ public:
+  RelativePtr() = default;
+  RelativePtr(std::nullptr_t) {}
+  RelativePtr(T* p) { Set(p); }
+  RelativePtr(const RelativePtr& other) { Set(other.get()); }
+
+  RelativePtr& operator=(const RelativePtr& other) {
+    Set(other.get());
+    return *this;
+  }
+
+  RelativePtr& operator=(T* p) {
+    Set(p);
+    return *this;
+  }
+
+  RelativePtr& operator=(std::nullptr_t) {
+    offset_ = 0;
+    return *this;
+  }
+
+  T* get() const {
+    if (offset_ == 0) return nullptr;
+    return reinterpret_cast<T*>(reinterpret_cast<intptr_t>(this) + offset_);
+  }
+
+  T& operator*() const { return *get(); }
+  T* operator->() const { return get(); }
+  T& operator[](ptrdiff_t i) const { return get()[i]; }
+  explicit operator bool() const { return offset_ != 0; }
+
+  // The raw distance in bytes from `this` to the target; 0 for null.
+  int64_t offset() const { return offset_; }
+
+  friend bool operator==(const RelativePtr& a, const RelativePtr& b) {
+    return a.get() == b.get();
+  }
+  friend bool operator!=(const RelativePtr& a, const RelativePtr& b) {
+    return a.get() != b.get();
+  }
+
+ private:
+  void Set(T* p) {
+    offset_ = p == nullptr ? 0
+                           : reinterpret_cast<intptr_t>(p) -
+                                 reinterpret_cast<intptr_t>(this);
+  }
+
+  int64_t offset_ = 0;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_RELATIVE_PTR_H_
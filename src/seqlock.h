@@ -0,0 +1,169 @@
+// A fixed-shape `Layout` blob with one writer and lock-free readers.
+//
+// The sequence counter is the first field of the allocation,
+//
+//   Layout<std::atomic<uint64_t>, Aligned<unsigned char, L::Alignment()>>
+//
+// so a small blob shares its cache line with the counter. The writer updates
+// the blob in place. Readers copy what they need and retry if a write
+// overlapped the copy. Readers never delay the writer, and nothing on the
+// update path takes a lock or does a read-modify-write.
+//
+//   using Stats = Layout<uint64_t, double, uint32_t>;  // counters, latencies,
+//   SeqlockBlob<Stats> stats(Stats(16, 64, 8));         // histogram
+//
+//   // The shard's thread (the only writer):
+//   stats.Update([&](unsigned char* p) {
+//     stats.layout().Pointer<0>(p)[kRequests] += 1;
+//     ...
+//   });
+//
+//   // Monitoring threads:
+//   uint64_t counters[16];
+//   double latencies[64];
+//   stats.Read<0, 1>(counters, latencies);   // a consistent snapshot of both
+//
+// The counter is odd while a write is in progress. A reader loads it, copies,
+// and loads it again. The copy is consistent if both loads saw the same even
+// value. The copy itself races with the writer by design, and the fences
+// around it keep the torn bytes from being used. As in Linux's seqlock, the
+// copy is a plain `memcpy`, so the element types of `L` must be trivially
+// copyable.
+//
+// Readers spin while the writer is inside `Update()`, so keep updates short.
+// There must be one writer at a time; use a mutex between writers if needed.
+
+#ifndef ABSL_CONTAINER_INTERNAL_SEQLOCK_H_
+#define ABSL_CONTAINER_INTERNAL_SEQLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+template <class L>
+class SeqlockBlob {
+  static_assert(
+      internal_layout::AllTriviallyCopyable<typename L::ElementTypes>::value,
+      "Readers copy the blob with memcpy");
+
+ public:
+  // The allocation: the counter, then the blob of `L`.
+  using BlockLayout =
+      Layout<std::atomic<uint64_t>, Aligned<unsigned char, L::Alignment()>>;
+
+  // A zero-filled blob of `layout`.
+  explicit SeqlockBlob(const L& layout) : layout_(layout) {
+    const BlockLayout block(1, layout.AllocSize());
+    block_ = static_cast<unsigned char*>(::operator new(
+        block.AllocSize(), std::align_val_t{BlockLayout::Alignment()}));
+    new (Seq()) std::atomic<uint64_t>(0);
+    memset(Blob(), 0, layout.AllocSize());
+  }
+
+  ~SeqlockBlob() {
+    ::operator delete(block_, std::align_val_t{BlockLayout::Alignment()});
+  }
+
+  SeqlockBlob(const SeqlockBlob&) = delete;
+  SeqlockBlob& operator=(const SeqlockBlob&) = delete;
+
+  const L& layout() const { return layout_; }
+  size_t size() const { return layout_.AllocSize(); }
+
+  // Number of completed updates.
+  uint64_t version() const {
+    return Seq()->load(std::memory_order_acquire) / 2;
+  }
+
+  // Runs `fn(p)` with the blob at `p` for writing. Only one thread may call
+  // `Update()` at a time.
+  template <class Fn>
+  void Update(Fn fn) {
+    std::atomic<uint64_t>* seq = Seq();
+    // The writer owns the counter, so a load and a store, not an increment.
+    const uint64_t s = seq->load(std::memory_order_relaxed);
+    seq->store(s + 1, std::memory_order_relaxed);
+    // The odd value is visible before any write to the blob.
+    std::atomic_thread_fence(std::memory_order_release);
+    fn(Blob());
+    seq->store(s + 2, std::memory_order_release);
+  }
+
+  // Copies the whole blob to `out` (`size()` bytes, aligned to
+  // `L::Alignment()` if it's to be read through `layout()`).
+  void ReadBlob(unsigned char* out) const {
+    ReadConsistent([&] { memcpy(out, Blob(), layout_.AllocSize()); });
+  }
+
+  // Copies arrays `N...` to `out...`, one buffer of `Size<N>()` elements per
+  // array, all from the same version.
+  template <size_t... N>
+  void Read(typename L::template ElementType<N>*... out) const {
+    ReadConsistent([&] {
+      (memcpy(out, layout_.template Pointer<N>(Blob()),
+              layout_.template ArrayBytes<N>()),
+       ...);
+    });
+  }
+
+  // One attempt of `Read<N...>()`: false, with `out...` unspecified, if a
+  // write was in progress or overlapped the copy.
+  template <size_t... N>
+  bool TryRead(typename L::template ElementType<N>*... out) const {
+    return TryCopy([&] {
+      (memcpy(out, layout_.template Pointer<N>(Blob()),
+              layout_.template ArrayBytes<N>()),
+       ...);
+    });
+  }
+
+ private:
+  static constexpr auto kBlock = BlockLayout::Partial(1);
+
+  std::atomic<uint64_t>* Seq() const {
+    return kBlock.template Pointer<0>(block_);
+  }
+  unsigned char* Blob() const { return kBlock.template Pointer<1>(block_); }
+
+  template <class Copy>
+  bool TryCopy(Copy copy) const {
+    const std::atomic<uint64_t>* seq = Seq();
+    const uint64_t before = seq->load(std::memory_order_acquire);
+    if (before & 1) return false;
+    copy();
+    // The copy's loads complete before the counter is read again.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq->load(std::memory_order_relaxed) == before;
+  }
+
+  template <class Copy>
+  void ReadConsistent(Copy copy) const {
+    for (int spins = 0; !TryCopy(copy); ++spins) {
+      // The writer may have been preempted inside `Update()`.
+      if (spins >= 64) {
+        std::this_thread::yield();
+        continue;
+      }
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+  }
+
+  const L layout_;
+  unsigned char* block_;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_SEQLOCK_H_
@@ -0,0 +1,175 @@
+// A reference-counted, immutable `Layout` blob with copy-on-write.
+//
+// The count lives in the same allocation as the blob, as the first field of
+//
+//   Layout<std::atomic<size_t>, Aligned<unsigned char, L::Alignment()>>
+//
+// so sharing costs no control block (unlike `std::shared_ptr`), and the blob
+// itself starts aligned to `L::Alignment()`: `data()` can be passed to
+// anything that takes a blob of `L` (`TryView()`, `WriteChecksums()`, ...).
+//
+//   using L = Layout<size_t, size_t, float, double>;
+//   SharedBlob<L> blob = SharedBlob<L>::Make(L(1, 1, n, m));  // zero-filled
+//   unsigned char* p = blob.MutableCopy();   // unique: no copy
+//   ...fill p...
+//
+//   SharedBlob<L> snapshot = blob;           // an atomic increment
+//   std::thread reader([snapshot] { use(snapshot.Slice<2>()); });
+//   blob.MutableCopy();                      // shared: copies, then writes
+//                                            // don't affect `snapshot`
+//
+// Copying, moving and destroying handles is thread-safe, like `shared_ptr`;
+// one handle must not be used by two threads at once if one of them calls a
+// non-const member. The blob is copied with `memcpy`, so the element types of
+// `L` must be trivially copyable.
+
+#ifndef ABSL_CONTAINER_INTERNAL_SHARED_BLOB_H_
+#define ABSL_CONTAINER_INTERNAL_SHARED_BLOB_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+template <class L>
+class SharedBlob {
+  static_assert(
+      internal_layout::AllTriviallyCopyable<typename L::ElementTypes>::value,
+      "The blob is copied with memcpy");
+
+ public:
+  // The allocation: the count, then the blob of `L`.
+  using BlockLayout =
+      Layout<std::atomic<size_t>, Aligned<unsigned char, L::Alignment()>>;
+
+  // A blob of `layout` with all bytes zero, owned by the new handle.
+  static SharedBlob Make(const L& layout) {
+    SharedBlob blob(layout, Allocate(layout));
+    memset(blob.mutable_data(), 0, layout.AllocSize());
+    return blob;
+  }
+
+  // A copy of the blob of `layout` at `src`.
+  static SharedBlob Copy(const L& layout, const unsigned char* src) {
+    SharedBlob blob(layout, Allocate(layout));
+    memcpy(blob.mutable_data(), src, layout.AllocSize());
+    return blob;
+  }
+
+  SharedBlob() = default;
+
+  SharedBlob(const SharedBlob& other)
+      : layout_(other.layout_), block_(other.block_) {
+    // Relaxed: the new handle is reached through `other`, which already
+    // orders the blob's contents before us.
+    if (block_ != nullptr) Count()->fetch_add(1, std::memory_order_relaxed);
+  }
+
+  SharedBlob(SharedBlob&& other) noexcept
+      : layout_(other.layout_), block_(std::exchange(other.block_, nullptr)) {}
+
+  SharedBlob& operator=(const SharedBlob& other) {
+    SharedBlob(other).swap(*this);
+    return *this;
+  }
+
+  SharedBlob& operator=(SharedBlob&& other) noexcept {
+    SharedBlob(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~SharedBlob() { Release(); }
+
+  void swap(SharedBlob& other) noexcept {
+    std::swap(layout_, other.layout_);
+    std::swap(block_, other.block_);
+  }
+
+  explicit operator bool() const { return block_ != nullptr; }
+
+  const L& layout() const { return layout_; }
+  const unsigned char* data() const {
+    return block_ == nullptr ? nullptr : Blob(block_);
+  }
+  size_t size() const { return block_ == nullptr ? 0 : layout_.AllocSize(); }
+
+  template <size_t N>
+  auto Pointer() const {
+    return layout_.template Pointer<N>(data());
+  }
+  template <size_t N>
+  auto Slice() const {
+    return layout_.template Slice<N>(data());
+  }
+
+  // Number of handles sharing the blob; 0 for an empty handle. Exact only if
+  // no other thread is copying or dropping handles to it.
+  size_t use_count() const {
+    return block_ == nullptr ? 0 : Count()->load(std::memory_order_acquire);
+  }
+
+  // A writable blob for this handle. If the blob is shared, it's copied first
+  // and this handle moves to the copy; other handles keep the old contents.
+  // Requires: a non-empty handle.
+  unsigned char* MutableCopy() {
+    // Acquire: pairs with the release of the handles dropped by other threads,
+    // so their reads of the blob happen before our writes.
+    if (Count()->load(std::memory_order_acquire) != 1) {
+      *this = Copy(layout_, data());
+    }
+    return mutable_data();
+  }
+
+ private:
+  static constexpr auto kBlock = BlockLayout::Partial(1);
+
+  SharedBlob(const L& layout, unsigned char* block)
+      : layout_(layout), block_(block) {}
+
+  static unsigned char* Allocate(const L& layout) {
+    const BlockLayout block(1, layout.AllocSize());
+    unsigned char* p = static_cast<unsigned char*>(::operator new(
+        block.AllocSize(), std::align_val_t{BlockLayout::Alignment()}));
+    new (block.template Pointer<0>(p)) std::atomic<size_t>(1);
+    return p;
+  }
+
+  static unsigned char* Blob(unsigned char* block) {
+    return kBlock.template Pointer<1>(block);
+  }
+
+  std::atomic<size_t>* Count() const {
+    return kBlock.template Pointer<0>(block_);
+  }
+
+  unsigned char* mutable_data() { return Blob(block_); }
+
+  void Release() {
+    if (block_ == nullptr) return;
+    if (Count()->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      ::operator delete(block_, std::align_val_t{BlockLayout::Alignment()});
+    }
+    block_ = nullptr;
+  }
+
+  static constexpr L EmptyLayout() {
+    return []<size_t... I>(std::index_sequence<I...>) {
+      return L((void(I), size_t{0})...);
+    }(std::make_index_sequence<L::NumTypes>());
+  }
+
+  L layout_ = EmptyLayout();
+  unsigned char* block_ = nullptr;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_SHARED_BLOB_H_
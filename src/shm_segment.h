@@ -0,0 +1,207 @@
+// A shared-memory region that hands out `Layout` blobs.
+//
+//   // Process A
+//   ShmSegment seg = ShmSegment::Create("foo", 1 << 20);
+//   const Layout<size_t, double> layout(1, n);
+//   unsigned char* p = seg.Allocate(layout);  // AllocSize() bytes aligned to
+//                                             // Alignment()
+//   ...fill the blob...
+//   seg.SetRoot(p);
+//   // pass seg.fd() to process B (fork, SCM_RIGHTS, /proc/<pid>/fd/<n>)
+//
+//   // Process B
+//   ShmSegment seg = ShmSegment::Attach(fd);
+//   unsigned char* p = seg.Root();  // different address, same bytes
+//
+// The region is backed by memfd_create(2) on Linux and by an unlinked
+// shm_open(3) object elsewhere. It starts with a small header that holds the
+// bump pointer, so any process that maps the segment can allocate. There is no
+// free: blobs live as long as the segment. Blobs should refer to each other
+// with `RelativePtr` or with `ToOffset()`/`FromOffset()`, never with absolute
+// pointers.
+//
+// Errors (the kernel refusing to create or map the region) are reported by
+// `valid() == false`; `Allocate()` returns nullptr when the segment is full.
+
+#ifndef ABSL_CONTAINER_INTERNAL_SHM_SEGMENT_H_
+#define ABSL_CONTAINER_INTERNAL_SHM_SEGMENT_H_
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <utility>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+class ShmSegment {
+ public:
+  ShmSegment() = default;
+
+  ShmSegment(ShmSegment&& other) noexcept
+      : fd_(std::exchange(other.fd_, -1)),
+        base_(std::exchange(other.base_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  ShmSegment& operator=(ShmSegment&& other) noexcept {
+    if (this != &other) {
+      Release();
+      fd_ = std::exchange(other.fd_, -1);
+      base_ = std::exchange(other.base_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  ~ShmSegment() { Release(); }
+
+  // Creates a new segment of `size` bytes (including the header). `name` is
+  // only used for debugging (/proc/<pid>/fd, /dev/shm).
+  static ShmSegment Create(const char* name, size_t size) {
+    ShmSegment seg;
+    if (size < sizeof(Header)) return seg;
+#if defined(__linux__)
+    int fd = memfd_create(name, MFD_CLOEXEC);
+#else
+    char path[64];
+    snprintf(path, sizeof(path), "/%s.%d", name, static_cast<int>(getpid()));
+    int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(path);
+#endif
+    if (fd < 0) return seg;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || !seg.Map(fd, size)) {
+      close(fd);
+      return seg;
+    }
+    Header* h = seg.header();
+    h->magic = kMagic;
+    h->size = size;
+    h->used.store(sizeof(Header), std::memory_order_relaxed);
+    h->root.store(0, std::memory_order_relaxed);
+    return seg;
+  }
+
+  // Maps an existing segment. Takes ownership of `fd`.
+  static ShmSegment Attach(int fd) {
+    ShmSegment seg;
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(Header) ||
+        !seg.Map(fd, static_cast<size_t>(st.st_size))) {
+      close(fd);
+      return seg;
+    }
+    if (seg.header()->magic != kMagic) return ShmSegment();
+    return seg;
+  }
+
+  bool valid() const { return base_ != nullptr; }
+  int fd() const { return fd_; }
+  unsigned char* base() const { return base_; }
+  size_t size() const { return size_; }
+
+  // Bytes handed out so far, including the header.
+  size_t used() const {
+    return header()->used.load(std::memory_order_relaxed);
+  }
+
+  // Allocates `size` bytes aligned to `alignment`. Thread- and process-safe.
+  // Returns nullptr if the segment doesn't have enough space left.
+  //
+  // Requires: `alignment` is a power of 2.
+  unsigned char* Allocate(size_t size, size_t alignment) {
+    assert(internal_layout::adl_barrier::IsPow2(alignment));
+    std::atomic<uint64_t>& used = header()->used;
+    uint64_t cur = used.load(std::memory_order_relaxed);
+    uint64_t begin;
+    do {
+      begin = internal_layout::adl_barrier::Align(cur, alignment);
+      if (begin > size_ || size > size_ - begin) return nullptr;
+    } while (!used.compare_exchange_weak(cur, begin + size,
+                                         std::memory_order_relaxed));
+    return base_ + begin;
+  }
+
+  // Allocates a blob for `layout`: `AllocSize()` bytes aligned to
+  // `Alignment()`.
+  template <class L>
+  unsigned char* Allocate(const L& layout) {
+    return Allocate(layout.AllocSize(), L::Alignment());
+  }
+
+  // Position-independent handles for blobs in the segment. Offset 0 is null.
+  uint64_t ToOffset(const void* p) const {
+    if (p == nullptr) return 0;
+    assert(Contains(p));
+    return static_cast<const unsigned char*>(p) - base_;
+  }
+
+  unsigned char* FromOffset(uint64_t off) const {
+    assert(off < size_);
+    return off == 0 ? nullptr : base_ + off;
+  }
+
+  bool Contains(const void* p) const {
+    auto* c = static_cast<const unsigned char*>(p);
+    return c >= base_ && c < base_ + size_;
+  }
+
+  // A well-known entry point for readers, e.g. the first blob.
+  void SetRoot(const void* p) {
+    header()->root.store(ToOffset(p), std::memory_order_release);
+  }
+
+  unsigned char* Root() const {
+    return FromOffset(header()->root.load(std::memory_order_acquire));
+  }
+
+ private:
+  static constexpr uint64_t kMagic = 0x746e656d67655348;  // "HSegment"
+
+  // Aligned to a cache line so that blobs never share a line with `used`.
+  struct alignas(64) Header {
+    uint64_t magic;
+    uint64_t size;
+    std::atomic<uint64_t> used;
+    std::atomic<uint64_t> root;
+  };
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "The header is shared between processes");
+
+  Header* header() const { return reinterpret_cast<Header*>(base_); }
+
+  bool Map(int fd, size_t size) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return false;
+    fd_ = fd;
+    base_ = static_cast<unsigned char*>(p);
+    size_ = size;
+    return true;
+  }
+
+  void Release() {
+    if (base_ != nullptr) munmap(base_, size_);
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    base_ = nullptr;
+    size_ = 0;
+  }
+
+  int fd_ = -1;
+  unsigned char* base_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_SHM_SEGMENT_H_
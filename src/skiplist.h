@@ -0,0 +1,230 @@
+// A lock-free, insert-only ordered index whose nodes are `Layout` blocks
+// allocated from an `Arena`.
+//
+//   Arena arena;
+//   ConcurrentSkipList<uint64_t, double> index(arena);
+//   // any number of threads:
+//   index.Insert(42, 1.5);                       // false if 42 is present
+//   if (const double* v = index.Find(42)) ...
+//   for (auto it = index.LowerBound(10); it != index.end() && it.key() < 20;
+//        ++it) ...
+//
+// A node of height `h` is one block:
+//
+//   Layout<K, V, std::atomic<Node*>>(1, 1, h)
+//
+// i.e. the key, the value and `h` next pointers; heights are geometric with
+// p = 1/4, so a node has 1.33 pointers on average, and the offset of the
+// pointer array doesn't depend on `h` (`Partial(1, 1)`), so the height doesn't
+// need to be stored. Nodes are bump-allocated from the thread's chunk of the
+// arena: no lock, no free.
+//
+// Insertion links the node level by level from the bottom with a CAS on the
+// predecessor's pointer, retrying the search from the predecessor when another
+// insert got in between (as in LevelDB/RocksDB's InlineSkipList). A node is in
+// the set once it's linked at level 0; upper levels are only shortcuts.
+// Readers never block and never see a partially built node: the key and value
+// are written before the node is published with a release CAS.
+//
+// There is no erase; memory is released with the arena. `K` and `V` must be
+// trivially destructible.
+
+#ifndef ABSL_CONTAINER_INTERNAL_SKIPLIST_H_
+#define ABSL_CONTAINER_INTERNAL_SKIPLIST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <new>
+#include <type_traits>
+
+#include "arena.h"
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+template <class K, class V, class Less = std::less<K>>
+class ConcurrentSkipList {
+  static_assert(std::is_trivially_destructible_v<K> &&
+                    std::is_trivially_destructible_v<V>,
+                "Nodes live in an arena and are never destroyed");
+
+  using Node = unsigned char;
+
+ public:
+  static constexpr int kMaxHeight = 16;
+  using NodeLayout = Layout<K, V, std::atomic<Node*>>;
+
+  class iterator {
+   public:
+    iterator() = default;
+    const K& key() const { return *Key(node_); }
+    const V& value() const { return *Value(node_); }
+    iterator& operator++() {
+      node_ = Next(node_, 0);
+      return *this;
+    }
+    bool operator==(const iterator& o) const { return node_ == o.node_; }
+    bool operator!=(const iterator& o) const { return node_ != o.node_; }
+
+   private:
+    friend class ConcurrentSkipList;
+    explicit iterator(Node* node) : node_(node) {}
+    Node* node_ = nullptr;
+  };
+
+  explicit ConcurrentSkipList(Arena& arena) : arena_(arena) {
+    head_ = arena_.Allocate(NodeLayout(1, 1, kMaxHeight));
+    for (int i = 0; i != kMaxHeight; ++i) {
+      new (NextArray(head_) + i) std::atomic<Node*>(nullptr);
+    }
+  }
+
+  ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+  ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+  // Approximate while inserts are running.
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  iterator begin() const { return iterator(Next(head_, 0)); }
+  iterator end() const { return iterator(); }
+
+  // First element whose key is not less than `k`.
+  iterator LowerBound(const K& k) const {
+    Node* x = head_;
+    for (int level = max_height_.load(std::memory_order_relaxed) - 1;
+         level >= 0; --level) {
+      for (Node* next = Next(x, level); next != nullptr && Less()(*Key(next), k);
+           next = Next(x, level)) {
+        x = next;
+      }
+    }
+    return iterator(Next(x, 0));
+  }
+
+  const V* Find(const K& k) const {
+    const iterator it = LowerBound(k);
+    if (it == end() || Less()(k, it.key())) return nullptr;
+    return Value(it.node_);
+  }
+
+  bool Contains(const K& k) const { return Find(k) != nullptr; }
+
+  // Inserts `(k, v)` unless `k` is present. Thread-safe and lock-free.
+  bool Insert(const K& k, const V& v) {
+    Node* prev[kMaxHeight];
+    Node* succ[kMaxHeight];
+    const int searched = max_height_.load(std::memory_order_relaxed);
+    FindSplice(k, searched, prev, succ);
+    if (IsEqual(succ[0], k)) return false;
+
+    const int height = RandomHeight();
+    // Raise the list's height. A failed CAS reloads `max_height`, which may
+    // be above `searched` if another insert raised it meanwhile.
+    int max_height = searched;
+    while (height > max_height) {
+      if (max_height_.compare_exchange_weak(max_height, height,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    // Levels that weren't searched start at the head. If another insert has
+    // linked a node there since, the CAS below fails and searches the level.
+    for (int level = searched; level < height; ++level) {
+      prev[level] = head_;
+      succ[level] = nullptr;
+    }
+
+    Node* x = NewNode(k, v, height);
+    for (int level = 0; level < height; ++level) {
+      for (;;) {
+        NextArray(x)[level].store(succ[level], std::memory_order_relaxed);
+        if (NextArray(prev[level])[level].compare_exchange_strong(
+                succ[level], x, std::memory_order_release,
+                std::memory_order_relaxed)) {
+          break;
+        }
+        // Someone linked a node after `prev[level]`: search again from there.
+        FindSpliceForLevel(k, level, prev[level], &prev[level], &succ[level]);
+        if (level == 0 && IsEqual(succ[0], k)) return false;
+      }
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  static constexpr auto kNode = NodeLayout::Partial(1, 1);
+
+  static K* Key(Node* n) { return kNode.template Pointer<0>(n); }
+  static V* Value(Node* n) { return kNode.template Pointer<1>(n); }
+  static std::atomic<Node*>* NextArray(Node* n) {
+    return kNode.template Pointer<2>(n);
+  }
+  static Node* Next(Node* n, int level) {
+    return NextArray(n)[level].load(std::memory_order_acquire);
+  }
+
+  bool IsEqual(Node* n, const K& k) const {
+    return n != nullptr && !Less()(k, *Key(n));
+  }
+
+  Node* NewNode(const K& k, const V& v, int height) {
+    Node* n = arena_.Allocate(NodeLayout(1, 1, height));
+    new (Key(n)) K(k);
+    new (Value(n)) V(v);
+    for (int i = 0; i != height; ++i) {
+      new (NextArray(n) + i) std::atomic<Node*>(nullptr);
+    }
+    return n;
+  }
+
+  // `prev[l]` and `succ[l]` for all levels below `height`: the last node with
+  // a key less than `k` and the node after it.
+  void FindSplice(const K& k, int height, Node** prev, Node** succ) const {
+    Node* x = head_;
+    for (int level = height - 1; level >= 0; --level) {
+      FindSpliceForLevel(k, level, x, &prev[level], &succ[level]);
+      x = prev[level];
+    }
+  }
+
+  void FindSpliceForLevel(const K& k, int level, Node* start, Node** prev,
+                          Node** succ) const {
+    Node* x = start;
+    for (;;) {
+      Node* next = Next(x, level);
+      if (next == nullptr || !Less()(*Key(next), k)) {
+        *prev = x;
+        *succ = next;
+        return;
+      }
+      x = next;
+    }
+  }
+
+  static int RandomHeight() {
+    thread_local uint64_t state =
+        0x9e3779b97f4a7c15 ^ reinterpret_cast<uintptr_t>(&state);
+    // xorshift64
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    // Two random bits per level: each level with probability 1/4.
+    const int zeros = __builtin_ctzll(state | (uint64_t{1} << 62)) / 2;
+    return zeros + 1 < kMaxHeight ? zeros + 1 : kMaxHeight;
+  }
+
+  Arena& arena_;
+  Node* head_;
+  std::atomic<int> max_height_{1};
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_SKIPLIST_H_
@@ -0,0 +1,189 @@
+// A lock-free single-producer/single-consumer ring of variable-size records,
+// sized and aligned by `Layout`.
+//
+//   SpscRing ring(1 << 20);
+//
+//   // Producer thread: reserve, fill in place, commit.
+//   const MyCompactFoo::L layout(1, 1, num_floats, num_doubles);
+//   unsigned char* p = ring.Reserve(layout);  // nullptr if the ring is full
+//   *layout.Pointer<0>(p) = num_floats;
+//   ...
+//   ring.Commit();
+//
+//   // Consumer thread: zero-copy view of the next record, then release it.
+//   if (const unsigned char* p = ring.Peek()) {
+//     constexpr auto partial = MyCompactFoo::L::Partial(1, 1);
+//     const MyCompactFoo::L layout(1, 1, *partial.Pointer<0>(p),
+//                                  *partial.Pointer<1>(p));
+//     auto floats = layout.Slice<2>(p);
+//     ...
+//     ring.Release();
+//   }
+//
+// Every record is an 8-byte header followed by the payload, aligned to the
+// alignment requested in `Reserve()` (at most `kMaxAlignment`). A record never
+// wraps around the end of the buffer: if it doesn't fit in the remaining tail,
+// the producer writes a padding record there and places the record at the
+// beginning. Readers never see padding records.
+//
+// The producer and the consumer each keep a cached copy of the other side's
+// position, so in the steady state a record costs one release store per side
+// and no cache-line ping-pong on every operation.
+
+#ifndef ABSL_CONTAINER_INTERNAL_SPSC_RING_H_
+#define ABSL_CONTAINER_INTERNAL_SPSC_RING_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <new>
+
+#include "layout.h"
+
+namespace absl {
+namespace container_internal {
+
+class SpscRing {
+ public:
+  // Alignment of the buffer and the largest alignment a record may request.
+  static constexpr size_t kMaxAlignment = internal_layout::kCacheLineSize;
+
+  // Requires: `capacity` is a power of 2 and at least `kMaxAlignment`.
+  explicit SpscRing(size_t capacity)
+      : buf_(static_cast<unsigned char*>(
+            ::operator new(capacity, std::align_val_t{kMaxAlignment}))),
+        capacity_(capacity) {
+    assert(internal_layout::adl_barrier::IsPow2(capacity));
+    assert(capacity >= kMaxAlignment);
+  }
+
+  ~SpscRing() { ::operator delete(buf_, std::align_val_t{kMaxAlignment}); }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t capacity() const { return capacity_; }
+
+  // ---- Producer side ------------------------------------------------------
+
+  // Reserves `size` bytes aligned to `alignment` for the next record and
+  // returns a pointer to them, or nullptr if the ring doesn't have enough free
+  // space right now. The record becomes visible to the consumer on `Commit()`.
+  // Calling `Reserve()` again without `Commit()` replaces the reservation.
+  //
+  // Requires: `alignment` is a power of 2, at most `kMaxAlignment`, and the
+  // record fits into an empty ring.
+  unsigned char* Reserve(size_t size, size_t alignment) {
+    using internal_layout::adl_barrier::Align;
+    assert(internal_layout::adl_barrier::IsPow2(alignment));
+    assert(alignment <= kMaxAlignment);
+    if (alignment < kHeaderSize) alignment = kHeaderSize;
+
+    const uint64_t pos = tail_;
+    size_t idx = pos & (capacity_ - 1);
+    size_t payload = Align(idx + kHeaderSize, alignment);
+    size_t end = Align(payload + size, kHeaderSize);
+    size_t skip = 0;
+    if (end > capacity_) {
+      // Doesn't fit in the tail of the buffer: pad it and start over at 0.
+      skip = capacity_ - idx;
+      idx = 0;
+      payload = Align(kHeaderSize, alignment);
+      end = Align(payload + size, kHeaderSize);
+      assert(end <= capacity_ && "Record larger than the ring");
+    }
+    const uint64_t next = pos + skip + end - idx;
+    if (next - cached_head_ > capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (next - cached_head_ > capacity_) return nullptr;
+    }
+
+    if (skip != 0) {
+      Header* pad = reinterpret_cast<Header*>(buf_ + (pos & (capacity_ - 1)));
+      pad->size = 0;
+      pad->payload = 0;
+    }
+    Header* h = reinterpret_cast<Header*>(buf_ + idx);
+    h->size = static_cast<uint32_t>(size);
+    h->payload = static_cast<uint32_t>(payload - idx);
+    pending_ = next;
+    return buf_ + payload;
+  }
+
+  // Reserves `AllocSize()` bytes aligned to `Alignment()` for a record
+  // described by `layout`.
+  template <class L>
+  unsigned char* Reserve(const L& layout) {
+    return Reserve(layout.AllocSize(), L::Alignment());
+  }
+
+  // Publishes the record returned by the last `Reserve()`.
+  void Commit() {
+    assert(pending_ != tail_);
+    tail_ = pending_;
+    tail_pub_.store(pending_, std::memory_order_release);
+  }
+
+  // ---- Consumer side ------------------------------------------------------
+
+  // The oldest committed record, or nullptr if there is none. The record stays
+  // valid until `Release()`. `size`, if not null, receives the size passed to
+  // `Reserve()`.
+  const unsigned char* Peek(size_t* size = nullptr) {
+    if (head_local_ == cached_tail_) {
+      cached_tail_ = tail_pub_.load(std::memory_order_acquire);
+      if (head_local_ == cached_tail_) return nullptr;
+    }
+    size_t idx = head_local_ & (capacity_ - 1);
+    const Header* h = reinterpret_cast<const Header*>(buf_ + idx);
+    if (h->payload == 0) {
+      // Padding record; the real one is at the beginning of the buffer.
+      head_local_ += capacity_ - idx;
+      idx = 0;
+      h = reinterpret_cast<const Header*>(buf_);
+    }
+    if (size != nullptr) *size = h->size;
+    release_to_ = head_local_ + internal_layout::adl_barrier::Align(
+                                    h->payload + h->size, kHeaderSize);
+    return buf_ + idx + h->payload;
+  }
+
+  // Frees the record returned by the last `Peek()`.
+  void Release() {
+    assert(release_to_ > head_local_);
+    head_local_ = release_to_;
+    head_.store(head_local_, std::memory_order_release);
+  }
+
+ private:
+  struct Header {
+    uint32_t size;     // payload size in bytes
+    uint32_t payload;  // from the header to the payload; 0 for padding
+  };
+  static constexpr size_t kHeaderSize = sizeof(Header);
+
+  unsigned char* const buf_;
+  const size_t capacity_;
+
+  static constexpr size_t kLine = internal_layout::kCacheLineSize;
+
+  // Written by the producer. `tail_` is the producer's private copy of
+  // `tail_pub_`, so that reserving doesn't touch the shared line.
+  alignas(kLine) std::atomic<uint64_t> tail_pub_{0};
+  alignas(kLine) uint64_t tail_ = 0;
+  uint64_t pending_ = 0;
+  uint64_t cached_head_ = 0;
+
+  // Written by the consumer.
+  alignas(kLine) std::atomic<uint64_t> head_{0};
+  alignas(kLine) uint64_t head_local_ = 0;
+  uint64_t release_to_ = 0;
+  uint64_t cached_tail_ = 0;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_SPSC_RING_H_
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "column_codec.h"
+
+using namespace absl::container_internal;
+
+int main()
+{
+  // uint32_t[n] ids，1 bit的null-bitmap，3 bit的枚举，13 bit的小整数；
+  using L = Layout<Field<"id", uint32_t>, Field<"null", Bits<1>>,
+                   Field<"state", Bits<3>>, Field<"small", Bits<13>>>;
+  const size_t n = 1000;
+  const L layout(n, n, n, n);
+
+  // 每个Bits数组按64 bit的word取整：1000 bit -> 16 word，3000 -> 47，13000 -> 204；
+  assert(layout.Offset<1>() == 4000);
+  assert(layout.ArrayBytes<1>() == 16 * 8);
+  assert(layout.Offset<2>() == 4000 + 16 * 8);
+  assert(layout.ArrayBytes<2>() == 47 * 8);
+  assert(layout.Offset<3>() == 4000 + 63 * 8);
+  assert(layout.AllocSize() == 4000 + (63 + 204) * 8);
+  static_assert(L::Alignment() == 8);
+  static_assert(std::is_same_v<decltype(layout.Pointer<"null">((unsigned char*)nullptr)), uint64_t*>);
+
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+  memset(p, 0, layout.AllocSize());
+
+  auto nulls = layout.Slice<"null">(p);
+  auto state = layout.Slice<"state">(p);
+  auto small = layout.Slice<"small">(p);
+  static_assert(std::is_same_v<decltype(nulls), BitSpan<1, uint64_t>>);
+  assert(nulls.size() == n && state.size() == n && small.size() == n);
+
+  for (size_t i = 0; i < n; ++i) {
+    nulls[i] = (i % 3 == 0);
+    state[i] = i % 8;
+    small[i] = (i * 37) & 8191;  // 13 bit，跨word的值也要正确；
+  }
+  for (size_t i = 0; i < n; ++i) {
+    assert(nulls[i] == (i % 3 == 0));
+    assert(state[i] == i % 8);
+    assert(small.get(i) == ((i * 37) & 8191));
+  }
+  // 写入会截断到K bit，不影响相邻的值；
+  state[10] = 0xff;
+  assert(state[10] == 7 && state[9] == 1 && state[11] == 3);
+  state[10] = 2;
+
+  // popcount / rank / select：i%3==0的个数是334；
+  assert(nulls.Count() == 334);
+  assert(nulls.Rank(0) == 0);
+  assert(nulls.Rank(1) == 1);
+  assert(nulls.Rank(64) == 22);
+  for (size_t k = 0; k < 334; ++k) assert(nulls.Select(k) == 3 * k);
+  assert(nulls.Select(334) == n);
+
+  // Unpack：bitmap展开成字节（AVX2）；从非word边界开始；
+  std::vector<uint8_t> bytes(n);
+  nulls.Unpack(5, n - 5, bytes.data());
+  for (size_t i = 5; i < n; ++i) assert(bytes[i - 5] == (i % 3 == 0));
+  state.Unpack(0, n, bytes.data());
+  for (size_t i = 0; i < n; ++i) assert(bytes[i] == (i == 10 ? 2 : i % 8));
+
+  std::vector<uint16_t> in(100), out(100);
+  for (size_t i = 0; i < 100; ++i) in[i] = 8191 - i;
+  small.Pack(900, 100, in.data());
+  small.Unpack(900, 100, out.data());
+  assert(in == out);
+  assert(small[899] == ((899 * 37) & 8191));
+
+  // const的slice只能读；迭代；
+  const unsigned char* cp = p;
+  auto cnulls = layout.Slice<1>(cp);
+  static_assert(std::is_same_v<decltype(cnulls), BitSpan<1, const uint64_t>>);
+  size_t ones = 0;
+  for (uint64_t b : cnulls) ones += b;
+  assert(ones == 334);
+
+  // 迭代器是random access的：可以用于二分查找、反向迭代；
+  static_assert(std::random_access_iterator<decltype(cnulls.begin())>);
+  auto small_c = layout.Slice<"small">(cp);
+  assert(small_c.begin()[899] == small[899]);
+  assert(*(small_c.end() - 1) == small[small.size() - 1]);
+  assert(std::count(std::make_reverse_iterator(cnulls.end()),
+                    std::make_reverse_iterator(cnulls.begin()), 1u) == 334);
+  {
+    // 单调递增的值上二分查找；
+    std::vector<uint64_t> w(4);
+    BitSpan<8, uint64_t> sorted(w.data(), 32);
+    for (size_t i = 0; i < 32; ++i) sorted.set(i, i * 3);
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), uint64_t{40});
+    assert(it - sorted.begin() == 14 && *it == 42);
+    assert(sorted.begin() < it && it <= sorted.end());
+  }
+
+  // SubLayout中的Bits；
+  {
+    using R = SubLayout<Layout<uint32_t, Bits<4>>, 1, 10>;
+    static_assert(sizeof(R) == 16);
+    R r{};
+    r.Slice<1>()[9] = 15;
+    assert(r.Slice<1>()[9] == 15 && r.Slice<1>()[8] == 0);
+  }
+
+  // column_codec按word编码Bits数组，解码回来相同；
+  std::vector<unsigned char> enc = EncodeColumns(layout, p);
+  EncodedColumns cols(enc.data(), enc.size());
+  assert(cols.valid() && cols.count(2) == n);
+  const L layout2 = cols.MakeLayout<L>();
+  unsigned char* q = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout2.AllocSize());
+  const bool decoded = cols.DecodeAll(layout2, q);
+  assert(decoded);
+  assert(memcmp(p, q, layout.AllocSize()) == 0);
+
+  //打印：
+  //  alignment 8, alloc 6136 B, payload 6136 B, padding 0 B (0.0%)
+  //    #0 <unsigned int> @0 1000x4 = 4000 B, padding 0 B, 63 line(s), 0 straddling
+  //    #1 <Bits<1>> @4000 1000x1b = 128 B, padding 0 B, 3 line(s), 0 straddling
+  //  ...
+  std::cout << layout.Report();
+
+  free(q);
+  free(p);
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "btree_map.h"
+
+using namespace absl::container_internal;
+
+int main()
+{
+  // 512字节的节点：leaf是header + 31个key + 31个value，internal是header + 30个key + 31个child；
+  using M = BTreeMap<int64_t, int64_t>;
+  static_assert(M::kLeafCapacity == 31 && M::kInnerCapacity == 30);
+  static_assert(M::kLeaf.AllocSize() <= 512 && M::kInner.AllocSize() <= 512);
+  static_assert(BTreeMap<uint32_t, uint32_t, 256>::kLeafCapacity == 30);
+
+  // SIMD的计数与标量的一致：有符号、无符号（最高位）、32位、尾部；
+  {
+    namespace bi = btree_internal;
+    std::vector<int64_t> a = {-5, -1, 0, 3, 3, 7, 100, INT64_MAX, INT64_MAX};
+    for (int64_t k : {INT64_MIN, int64_t{-1}, int64_t{3}, int64_t{8}, INT64_MAX}) {
+      for (size_t n = 0; n <= a.size(); ++n) {
+        assert(bi::Count<false>(a.data(), n, k) == bi::CountScalar<false>(a.data(), n, k));
+        assert(bi::Count<true>(a.data(), n, k) == bi::CountScalar<true>(a.data(), n, k));
+      }
+    }
+    std::vector<uint64_t> u = {1, 5, 1ull << 63, (1ull << 63) + 1, UINT64_MAX};
+    assert(bi::Count<false>(u.data(), u.size(), uint64_t{1} << 63) == 2);
+    assert(bi::Count<true>(u.data(), u.size(), uint64_t{1} << 63) == 3);
+    std::vector<uint32_t> w(19);
+    for (size_t i = 0; i < w.size(); ++i) w[i] = i * 0x08000000u;
+    assert(bi::Count<false>(w.data(), w.size(), 0x80000000u) == 16);
+  }
+
+  // 与std::map对照：随机插入、删除、查找、lower_bound；
+  M m;
+  std::map<int64_t, int64_t> ref;
+  srand(1);
+  for (int round = 0; round < 200000; ++round) {
+    const int64_t k = rand() % 20000 - 10000;
+    switch (rand() % 4) {
+      case 0:
+      case 1: {
+        auto [it, inserted] = m.insert(k, round);
+        auto r = ref.insert({k, round});
+        assert(inserted == r.second && it.key() == k && it.value() == r.first->second);
+        break;
+      }
+      case 2: {
+        const size_t erased = m.erase(k);
+        const size_t expected = ref.erase(k);
+        assert(erased == expected);
+        break;
+      }
+      default: {
+        auto it = m.lower_bound(k);
+        auto r = ref.lower_bound(k);
+        assert((it == m.end()) == (r == ref.end()));
+        if (r != ref.end()) assert(it.key() == r->first && it.value() == r->second);
+        assert(m.contains(k) == ref.count(k));
+      }
+    }
+    assert(m.size() == ref.size());
+  }
+
+  // 顺序遍历与std::map相同；
+  auto r = ref.begin();
+  for (auto it = m.begin(); it != m.end(); ++it, ++r) {
+    assert(it.key() == r->first && it.value() == r->second);
+  }
+  assert(r == ref.end());
+
+  // 区间扫描[lo, hi)；
+  for (auto [lo, hi] : {std::pair<int64_t, int64_t>{-10000, 10000}, {-3, 500}, {7, 8}, {5, 5}, {9000, 20000}}) {
+    std::vector<int64_t> got, want;
+    m.Scan(lo, hi, [&](int64_t k, int64_t& v) {
+      assert(v == ref[k]);
+      got.push_back(k);
+    });
+    for (auto it = ref.lower_bound(lo); it != ref.end() && it->first < hi; ++it) want.push_back(it->first);
+    assert(got == want);
+  }
+
+  // 顺序插入：一百万个key，高度为log_31；
+  {
+    M big;
+    for (int64_t i = 0; i < 1000000; ++i) big.insert(i, i * 2);
+    // 追加时节点保持满的：叶子数 = ceil(1000000 / 31)；
+    assert(big.size() == 1000000 && big.height() == 4);
+    assert(big.node_count() < 1000000 / 31 * 104 / 100);
+    for (int64_t i = 0; i < 1000000; i += 997) assert(big.find(i).value() == i * 2);
+    assert(big.find(1000000) == big.end());
+    int64_t sum = 0;
+    big.Scan(100, 200, [&](int64_t, int64_t& v) { sum += v; });
+    assert(sum == 2 * (100 + 199) * 100 / 2);
+
+    M moved = std::move(big);
+    assert(moved.size() == 1000000 && big.empty() && big.begin() == big.end());
+    moved[5] = 7;
+    assert(moved.find(5).value() == 7);
+  }
+
+  // 浮点key：标量计数；
+  {
+    BTreeMap<double, int> d;
+    for (int i = 0; i < 1000; ++i) d.insert(i * 0.5, i);
+    assert(d.lower_bound(10.25).key() == 10.5);
+  }
+
+  //打印：nodes: 31 key/value per leaf, height 3
+  std::cout << "nodes: " << M::kLeafCapacity << " key/value per leaf, height " << m.height() << std::endl;
+  return 0;
+}
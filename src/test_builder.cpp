@@ -0,0 +1,71 @@
+#include <iostream>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "parallel_builder.h"
+#include "thread_pool.h"
+
+using namespace absl::container_internal;
+
+// 12字节的元素：大小不是2的幂，会跨chunk边界；
+struct Vec3 {
+  float x, y, z;
+};
+
+int main()
+{
+  {
+    // ThreadPool：Run在每个worker上各执行一次，ParallelFor覆盖所有下标；
+    ThreadPool pool(4);
+    std::vector<int> ran(pool.size());
+    pool.Run([&](size_t w) { ran[w]++; });
+    for (int r : ran) assert(r == 1);
+
+    std::vector<int> hit(1000);
+    pool.ParallelFor(hit.size(), [&](size_t i) { hit[i]++; }, 7);
+    for (int h : hit) assert(h == 1);
+  }
+
+  {
+    // size_t[1], size_t[1], Vec3[n], double[m]；chunk取最小（1页），让字段被切成很多块；
+    using L = Layout<size_t, size_t, Vec3, double>;
+    const size_t n = 100000, m = 70001;
+    std::vector<Vec3> vecs(n);
+    for (size_t i = 0; i < n; ++i) vecs[i] = {float(i), float(i) + 0.5f, -float(i)};
+
+    ThreadPool pool(3);
+    const L layout(1, 1, n, m);
+    ParallelBuilder<L> builder(pool, layout, 1);
+    assert(builder.data() != nullptr);
+    builder.Transform<0>([&](size_t) { return n; });
+    builder.Transform<1>([&](size_t) { return m; });
+    builder.Copy<2>(vecs.data());
+    builder.Transform<3>([](size_t i) { return i * 0.25; });
+    assert(builder.stats().bytes == 16 + n * 12 + m * 8);
+
+    MappedBlock block = builder.Release();
+    const unsigned char* p = block.data();
+    assert(builder.data() == nullptr);
+
+    // 和test_serialize.cpp中的use()一样读回来；
+    constexpr auto partial = L::Partial(1, 1);
+    assert(*partial.Pointer<0>(p) == n);
+    assert(*partial.Pointer<1>(p) == m);
+    const Vec3* v = layout.Pointer<2>(p);
+    for (size_t i = 0; i < n; ++i) {
+      assert(v[i].x == float(i) && v[i].y == float(i) + 0.5f);
+      assert(v[i].z == -float(i));
+    }
+    const double* d = layout.Pointer<3>(p);
+    for (size_t i = 0; i < m; ++i) assert(d[i] == i * 0.25);
+
+    //打印：built 1760024 bytes
+    std::cout << "built " << builder.stats().bytes << " bytes" << std::endl;
+  }
+
+  return 0;
+}
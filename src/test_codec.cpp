@@ -0,0 +1,132 @@
+#include <iostream>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "column_codec.h"
+
+using namespace absl::container_internal;
+
+// 每个数组的数据特点不同，应各自选中不同的codec；
+using L = Layout<Field<"id", uint64_t>, Field<"level", int16_t>,
+                 Field<"flag", uint8_t>, Field<"temp", double>,
+                 Field<"noise", float>, Field<"ts", int64_t>>;
+
+int main()
+{
+  const size_t n = 10007;
+  const L layout(n, n, n, n, n, n);
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+
+  uint64_t* id = layout.Pointer<"id">(p);
+  int16_t* level = layout.Pointer<"level">(p);
+  uint8_t* flag = layout.Pointer<"flag">(p);
+  double* temp = layout.Pointer<"temp">(p);
+  float* noise = layout.Pointer<"noise">(p);
+  int64_t* ts = layout.Pointer<"ts">(p);
+  srand(1);
+  for (size_t i = 0; i < n; ++i) {
+    id[i] = 1000000 + (rand() % 1000);         // 范围小：for
+    level[i] = -100 + (rand() % 37);           // 负数，范围小：for
+    flag[i] = (i / 1000) % 2;                  // 长run：rle
+    temp[i] = 20.0 + (i / 50) * 0.5;           // 缓慢变化：xor
+    uint32_t bits = rand() ^ (rand() << 16);   // 随机的bit：raw
+    memcpy(&noise[i], &bits, 4);
+    ts[i] = 1700000000000 + i * 1000 + (i % 3); // 单调递增：delta
+  }
+
+  std::vector<unsigned char> enc = EncodeColumns(layout, p);
+  EncodedColumns cols(enc.data(), enc.size());
+  assert(cols.valid());
+  assert(cols.num_columns() == 6);
+  assert(cols.codec(0) == Codec::kFor);
+  assert(cols.codec(1) == Codec::kFor);
+  assert(cols.codec(2) == Codec::kRle);
+  assert(cols.codec(3) == Codec::kXor);
+  assert(cols.codec(4) == Codec::kRaw);
+  assert(cols.codec(5) == Codec::kDelta);
+  assert(cols.encoded_bytes(0) == (n * 10 + 7) / 8);   // 1000需要10 bits；
+  assert(cols.encoded_bytes(5) == ((n - 1) * 2 + 7) / 8);  // delta为998..1001：2 bits；
+
+  // 解码到一个新的block，与原始的逐字节相同；
+  const L layout2 = cols.MakeLayout<L>();
+  assert(layout2.AllocSize() == layout.AllocSize());
+  unsigned char* q = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout2.AllocSize());
+  memset(q, 0xff, layout2.AllocSize());
+  bool ok = cols.DecodeAll(layout2, q);
+  assert(ok);
+  // 各数组之间的padding不属于任何数组，不比较；
+  assert(memcmp(layout.Pointer<0>(p), layout2.Pointer<0>(q), n * 8) == 0);
+  assert(memcmp(layout.Pointer<1>(p), layout2.Pointer<1>(q), n * 2) == 0);
+  assert(memcmp(layout.Pointer<2>(p), layout2.Pointer<2>(q), n * 1) == 0);
+  assert(memcmp(layout.Pointer<3>(p), layout2.Pointer<3>(q), n * 8) == 0);
+  assert(memcmp(layout.Pointer<4>(p), layout2.Pointer<4>(q), n * 4) == 0);
+  assert(memcmp(layout.Pointer<5>(p), layout2.Pointer<5>(q), n * 8) == 0);
+
+  // 只解码一个数组；长度不匹配时失败；
+  memset(layout2.Pointer<"ts">(q), 0, n * 8);
+  ok = cols.Decode<5>(layout2, q);
+  assert(ok);
+  assert(layout2.Pointer<"ts">(q)[n - 1] == ts[n - 1]);
+  const L shorter(n, n, n, n, n, n - 1);
+  ok = cols.Decode<5>(shorter, q);
+  assert(!ok);
+
+  // 损坏的输入：magic错误，截断；
+  std::vector<unsigned char> bad = enc;
+  bad[0] ^= 1;
+  assert(!EncodedColumns(bad.data(), bad.size()).valid());
+  assert(!EncodedColumns(enc.data(), enc.size() - 9).valid());
+
+  // 伪造rle的run数：1<<62乘以每个run的字节数会溢出，不能因此通过检查；
+  {
+    const size_t at = sizeof(EncodedHeader) + 2 * sizeof(ColumnHeader) +
+                      offsetof(ColumnHeader, aux);
+    uint64_t runs;
+    memcpy(&runs, enc.data() + at, sizeof(runs));
+    for (uint64_t forged : {uint64_t{1} << 62, ~uint64_t{0}, runs + 1}) {
+      bad = enc;
+      memcpy(bad.data() + at, &forged, sizeof(forged));
+      assert(!EncodedColumns(bad.data(), bad.size()).valid());
+    }
+  }
+
+  // 常数列：for的bit width为0，payload为空；
+  {
+    using L1 = Layout<int32_t, double>;
+    const L1 l1(100, 100);
+    unsigned char* r = (unsigned char*)aligned_alloc_posix(L1::Alignment(), l1.AllocSize());
+    for (size_t i = 0; i < 100; ++i) {
+      l1.Pointer<0>(r)[i] = -7;
+      l1.Pointer<1>(r)[i] = 3.25;
+    }
+    std::vector<unsigned char> e = EncodeColumns(l1, r);
+    EncodedColumns c(e.data(), e.size());
+    assert(c.codec(0) == Codec::kFor && c.encoded_bytes(0) == 0);
+    memset(r, 0, l1.AllocSize());
+    const bool decoded = c.DecodeAll(l1, r);
+    assert(decoded);
+    assert(l1.Pointer<0>(r)[99] == -7 && l1.Pointer<1>(r)[99] == 3.25);
+    free(r);
+  }
+
+  //打印：raw 310224 bytes, encoded 64387 bytes
+  //       0: for 12509
+  //       ...
+  std::cout << "raw " << layout.AllocSize() << " bytes, encoded " << enc.size()
+            << " bytes" << std::endl;
+  for (size_t i = 0; i < cols.num_columns(); ++i) {
+    std::cout << "  " << i << ": " << CodecName(cols.codec(i)) << " "
+              << cols.encoded_bytes(i) << std::endl;
+  }
+
+  free(q);
+  free(p);
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "checksum.h"
+#include "crc32c.h"
+#include "thread_pool.h"
+
+using namespace absl::container_internal;
+
+int main()
+{
+  // 标准的check值；
+  assert(Crc32c("123456789", 9) == 0xe3069283);
+  assert(Crc32c("", 0) == 0);
+  assert(Crc32c("56789", 5, Crc32c("1234", 4)) == 0xe3069283);
+
+  // 硬件（含3路交错）与查表的结果一致：各种长度、各种起始对齐；
+  std::vector<unsigned char> buf(100000);
+  srand(1);
+  for (auto& b : buf) b = rand();
+  for (size_t len : {0, 1, 7, 8, 63, 4096, 12287, 12288, 12289, 50001, 99990}) {
+    for (size_t off = 0; off < 8; off += 3) {
+      const uint32_t table =
+          ~crc32c_internal::ExtendTable(~uint32_t{0}, buf.data() + off, len);
+      assert(Crc32c(buf.data() + off, len) == table);
+    }
+  }
+
+  // combine：crc(A B)由crc(A)、crc(B)和len(B)得到；
+  for (size_t split : {0, 1, 1000, 99999, 100000}) {
+    const uint32_t a = Crc32c(buf.data(), split);
+    const uint32_t b = Crc32c(buf.data() + split, buf.size() - split);
+    assert(Crc32cCombine(a, b, buf.size() - split) == Crc32c(buf.data(), buf.size()));
+  }
+
+  // 并行：每个worker一段，再combine；
+  ThreadPool pool(4);
+  assert(Crc32cParallel(pool, buf.data(), buf.size(), 0, 0) == Crc32c(buf.data(), buf.size()));
+  assert(Crc32cParallel(pool, buf.data(), 5000, 7, 0) == Crc32c(buf.data(), 5000, 7));
+
+  using L = Layout<Field<"id", uint32_t>, Field<"flag", char>, Field<"price", double>>;
+  const L layout(1000, 3, 500);
+  for (ChecksumMode mode : {ChecksumMode::kBlob, ChecksumMode::kPerField}) {
+    const size_t size = ChecksummedSize(layout, mode);
+    unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), size);
+    memset(p, 0, layout.AllocSize());
+    for (size_t i = 0; i < 1000; ++i) layout.Pointer<"id">(p)[i] = i * 7;
+    for (size_t i = 0; i < 500; ++i) layout.Pointer<"price">(p)[i] = i * 0.5;
+    const size_t written = WriteChecksums(layout, p, mode, &pool);
+    assert(written == size);
+
+    // 按字段算的blob CRC（拼接）与整块算的相同；
+    size_t blob_size = 0;
+    assert(VerifyChecksums(p, size, nullptr, &blob_size));
+    assert(blob_size == layout.AllocSize());
+    assert(VerifyChecksums(p, size, &pool));
+    assert(FindCorruptField(layout, p, size) == (mode == ChecksumMode::kPerField ? -1 : 3));
+
+    // 翻转一个bit：能发现，按字段模式还能定位到字段；
+    layout.Pointer<"price">(p)[17] += 1;
+    assert(!VerifyChecksums(p, size));
+    if (mode == ChecksumMode::kPerField) assert(FindCorruptField(layout, p, size) == 2);
+    layout.Pointer<"price">(p)[17] -= 1;
+    assert(VerifyChecksums(p, size));
+
+    // trailer本身损坏、长度不对；
+    p[size - 10] ^= 1;
+    assert(!VerifyChecksums(p, size));
+    p[size - 10] ^= 1;
+    assert(!VerifyChecksums(p, size - 1));
+    free(p);
+  }
+
+  // 文件：写出，映射时校验；
+  {
+    unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+    memset(p, 0, layout.AllocSize());
+    layout.Pointer<"id">(p)[999] = 42;
+    char path[] = "/tmp/test_crc.XXXXXX";
+    const int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    const bool saved =
+        WriteLayoutFile(path, layout, p, ChecksumMode::kPerField, &pool);
+    assert(saved);
+
+    MappedLayoutFile f = MappedLayoutFile::Open(path, true, &pool);
+    assert(f.valid() && f.blob_size() == layout.AllocSize());
+    assert(reinterpret_cast<uintptr_t>(f.data()) % L::Alignment() == 0);
+    assert(layout.Pointer<"id">(f.data())[999] == 42);
+    assert(FindCorruptField(layout, f.data(), f.file_size()) == -1);
+
+    // 改动文件中的一个字节：不校验时照样映射，校验时失败；
+    FILE* file = fopen(path, "r+b");
+    fseek(file, layout.Offset<"price">() + 3, SEEK_SET);
+    fputc(0x5a, file);
+    fclose(file);
+    const MappedLayoutFile unchecked = MappedLayoutFile::Open(path, false);
+    assert(unchecked.valid());
+    const MappedLayoutFile checked = MappedLayoutFile::Open(path, true);
+    assert(!checked.valid());
+    f = MappedLayoutFile::Open(path, false);
+    assert(FindCorruptField(layout, f.data(), f.file_size()) == 2);
+
+    const MappedLayoutFile missing =
+        MappedLayoutFile::Open("/nonexistent/x.blob", false);
+    assert(!missing.valid());
+    unlink(path);
+    free(p);
+  }
+
+  //打印：crc32c("123456789") = 0xe3069283
+  std::cout << "crc32c(\"123456789\") = 0x" << std::hex << Crc32c("123456789", 9) << std::endl;
+  return 0;
+}
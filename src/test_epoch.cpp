@@ -0,0 +1,116 @@
+#include <atomic>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "epoch.h"
+#include "layout.h"
+
+using namespace absl::container_internal;
+
+// 路由表：size_t[1]存储条目数，uint64_t[n]中每个条目都等于版本号；
+using L = Layout<size_t, uint64_t>;
+
+std::atomic<size_t> reclaimed{0};
+
+unsigned char* NewTable(size_t n, uint64_t version)
+{
+  const L layout(1, n);
+  unsigned char* p = static_cast<unsigned char*>(
+      ::operator new(layout.AllocSize(), std::align_val_t{L::Alignment()}));
+  *layout.Pointer<0>(p) = n;
+  for (size_t i = 0; i < n; ++i) layout.Pointer<1>(p)[i] = version;
+  return p;
+}
+
+void FreeTable(unsigned char* p)
+{
+  // 先写坏内容：若读者还在使用，会被检测到；
+  const L layout(1, *L::Partial().Pointer<0>(p));
+  memset(p, 0xee, layout.AllocSize());
+  ::operator delete(p, std::align_val_t{L::Alignment()});
+  reclaimed.fetch_add(1);
+}
+
+// 检查表的内容是否一致；返回版本号；
+uint64_t Check(const unsigned char* p)
+{
+  const L layout(1, *L::Partial().Pointer<0>(p));
+  const uint64_t* v = layout.Pointer<1>(p);
+  for (size_t i = 1; i < layout.Size<1>(); ++i) assert(v[i] == v[0]);
+  return v[0];
+}
+
+int main()
+{
+  {
+    // 单线程：读者还在临界区内时，不回收；
+    EpochDomain domain;
+    EpochPtr<unsigned char> table(NewTable(4, 1));
+    {
+      auto guard = domain.Read();
+      const unsigned char* old = table.load();
+      table.Publish(domain, NewTable(4, 2), FreeTable);
+      assert(domain.pending() == 1);
+      assert(domain.Collect() == 0 && Check(old) == 1);
+      {
+        auto inner = domain.Read();  // 嵌套
+        assert(Check(table.load()) == 2);
+      }
+      assert(domain.Collect() == 0 && Check(old) == 1);
+    }
+    assert(domain.Collect() == 1 && reclaimed == 1);
+
+    // 之后进入的读者不阻止回收；
+    {
+      auto guard = domain.Read();
+      table.Publish(domain, NewTable(4, 3), FreeTable);
+      assert(domain.Collect() == 0);
+    }
+    {
+      auto guard = domain.Read();
+      assert(domain.Collect() == 1 && reclaimed == 2);
+      assert(Check(table.load()) == 3);
+    }
+    FreeTable(table.load());
+    reclaimed = 0;
+  }
+
+  {
+    // 多线程：读者持续读取，写者不断发布新表；
+    EpochDomain domain;
+    EpochPtr<unsigned char> table(NewTable(64, 0));
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([&] {
+        uint64_t last = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+          auto guard = domain.Read();
+          const uint64_t v = Check(table.load());
+          assert(v >= last);  // 版本号不回退
+          last = v;
+        }
+      });
+    }
+    const uint64_t kVersions = 2000;
+    for (uint64_t v = 1; v <= kVersions; ++v) {
+      table.Publish(domain, NewTable(64, v), FreeTable);
+      if (v % 100 == 0) std::this_thread::yield();
+    }
+    stop = true;
+    for (auto& th : readers) th.join();
+    domain.Synchronize();
+    assert(domain.pending() == 0 && reclaimed == kVersions);
+    FreeTable(table.load());
+  }
+
+  //打印：epoch ok
+  std::cout << "epoch ok" << std::endl;
+  return 0;
+}
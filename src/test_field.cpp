@@ -0,0 +1,86 @@
+#include <iostream>
+#include <utility>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+
+using namespace absl::container_internal;
+
+int main()
+{
+  {
+    // 3个uint64_t数组：只能用下标访问（Pointer<uint64_t>会因为类型重复而编译失败），
+    // 给它们起名字之后，就可以按名字访问；
+    using L = Layout<Field<"ts", uint64_t>, Field<"seq", uint64_t>,
+                     Field<"len", uint32_t>, Field<"val", double>>;
+
+    // 按名字访问和按下标访问完全等价，且在编译期完成；
+    constexpr L layout(3, 3, 5, 2);
+    static_assert(L::NameIndex<"ts">() == 0);
+    static_assert(L::NameIndex<"val">() == 3);
+    static_assert(layout.Offset<"ts">() == 0);
+    static_assert(layout.Offset<"seq">() == 24);
+    static_assert(layout.Offset<"len">() == 48);
+    static_assert(layout.Offset<"val">() == 72);  // 48 + 5*4 = 68，对齐到72
+    static_assert(layout.Size<"len">() == 5);
+    static_assert(layout.AllocSize() == 88);
+    static_assert(std::is_same_v<L::ElementType<1>, uint64_t>);
+
+    // 错误：名字不存在
+    //   static_assert failed: Field name not found or not unique
+    // layout.Offset<"foo">();
+
+    unsigned char* p =
+        (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+
+    uint64_t* ts  = layout.Pointer<"ts">(p);
+    uint64_t* seq = layout.Pointer<"seq">(p);
+    assert(ts == layout.Pointer<0>(p));
+    assert(seq == layout.Pointer<1>(p));
+    assert((void*)layout.Pointer<"val">(p) == (void*)(p + 72));
+
+    for (int i = 0; i < 3; ++i) {
+      ts[i] = 1000 + i;
+      seq[i] = i;
+    }
+    // SliceType(boost::beast::span)只提供const迭代器，写入要通过data()；
+    auto len = layout.Slice<"len">(p);
+    for (size_t i = 0; i < len.size(); ++i) len.data()[i] = 7;
+    layout.Slice<"val">(p).data()[1] = 2.5;
+
+    // 类型唯一的字段仍然可以按类型访问；
+    assert(layout.Pointer<uint32_t>(p)[4] == 7);
+    assert(layout.Pointer<double>(p)[1] == 2.5);
+
+    // const指针得到const数组；
+    const unsigned char* cp = p;
+    auto ts_slice = layout.Slice<"ts">(cp);
+    static_assert(std::is_same_v<decltype(ts_slice),
+                                 internal_layout::SliceType<const uint64_t>>);
+    //打印：1000 1001 1002
+    for (auto e : ts_slice) std::cout << e << " ";
+    std::cout << std::endl;
+
+    // Partial同样可以按名字访问；
+    constexpr auto partial = L::Partial(3);
+    static_assert(partial.Offset<"seq">() == 24);
+    assert(partial.Pointer<"seq">(p)[2] == 2);
+
+    free(p);
+  }
+
+  {
+    // 名字可以和Aligned组合；
+    using L = Layout<Field<"tag", char>, Field<"ids", Aligned<uint64_t, 64>>>;
+    static_assert(L::Alignment() == 64);
+    constexpr L layout(1, 2);
+    static_assert(layout.Offset<"ids">() == 64);
+    static_assert(layout.AllocSize() == 80);
+  }
+
+  return 0;
+}
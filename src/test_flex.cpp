@@ -0,0 +1,81 @@
+#include <array>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "flex_object.h"
+
+using namespace absl::container_internal;
+
+// MyCompactFoo的FlexObject版本：header中存储两个数组的长度；
+struct FooHeader {
+  uint32_t id;
+  uint32_t num_floats;
+  uint32_t num_doubles;
+  std::array<size_t, 2> counts() const { return {num_floats, num_doubles}; }
+};
+using Foo = FlexObject<FooHeader, float, double>;
+
+// 统计构造/析构次数的元素；
+int live = 0;
+struct Tracked {
+  Tracked() { ++live; }
+  ~Tracked() { --live; }
+  std::string s = "x";
+};
+
+struct NameHeader {
+  size_t n;
+  std::array<size_t, 1> counts() const { return {n}; }
+};
+
+int main()
+{
+  {
+    // 一次分配：header，float[3]，double[4]；
+    Foo foo = Foo::Make(FooHeader{7, 3, 4});
+    assert(foo && foo->id == 7);
+    assert(foo.Slice<0>().size() == 3 && foo.Slice<1>().size() == 4);
+    assert(foo.Slice<0>().data()[0] == 0.0f && foo.Slice<1>().data()[3] == 0.0);  // 值初始化
+    float f[3] = {1.1, 2.2, 3.3};
+    double d[4] = {4.4, 5.5, 6.6, 7.7};
+    for (int i = 0; i < 3; ++i) foo.Pointer<0>()[i] = f[i];
+    for (int i = 0; i < 4; ++i) foo.Slice<1>().data()[i] = d[i];
+
+    // 12B header，float[3]结束于24，double[4]结束于56；
+    assert(foo.size() == 56);
+    assert(foo.size() == Foo::L(1, 3, 4).AllocSize());
+    assert(reinterpret_cast<uintptr_t>(foo.data()) % Foo::L::Alignment() == 0);
+    assert(reinterpret_cast<const unsigned char*>(foo.Pointer<1>()) ==
+           foo.data() + 24);
+
+    // 只能移动；
+    Foo moved = std::move(foo);
+    assert(!foo && foo.size() == 0);
+    const Foo& c = moved;
+    assert(c.Slice<0>().data()[2] == 3.3f && c.Slice<1>().data()[0] == 4.4);
+    foo = std::move(moved);
+    assert(foo && !moved && foo->num_doubles == 4);
+  }
+
+  {
+    // 非平凡元素：构造与析构；
+    using Names = FlexObject<NameHeader, Tracked>;
+    {
+      Names a = Names::Make(NameHeader{5});
+      assert(live == 5 && a.Slice<0>().data()[4].s == "x");
+      Names b = Names::Make(NameHeader{2});
+      assert(live == 7);
+      a = std::move(b);
+      assert(live == 2);
+    }
+    assert(live == 0);
+  }
+
+  //打印：flex ok
+  std::cout << "flex ok" << std::endl;
+  return 0;
+}
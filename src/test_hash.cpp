@@ -0,0 +1,150 @@
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "flat_hash_map.h"
+
+using namespace absl::container_internal;
+
+// 所有key的hash都相同：每次查找都要走完整个probe序列；
+struct BadHash {
+  size_t operator()(int) const { return 42; }
+};
+
+int main()
+{
+  using M = FlatHashMap<uint64_t, double>;
+  namespace fi = flat_hash_map_internal;
+
+  // 控制字节和slot在同一个Layout块中：ctrl_t[capacity + kGroupWidth]，然后是16字节对齐的slot；
+  {
+    M m;
+    assert(m.empty() && m.capacity() == 0 && m.find(1) == m.end() && m.begin() == m.end());
+    m[1] = 1.5;
+    assert(m.capacity() == fi::kGroupWidth - 1);
+    const M::L layout = m.layout();
+    assert(layout.Size<0>() == m.capacity() + fi::kGroupWidth);
+    assert(layout.Offset<1>() % 16 == 0);
+    assert(layout.AllocSize() == layout.Offset<1>() + m.capacity() * sizeof(std::pair<uint64_t, double>));
+  }
+
+  // 与std::unordered_map对照：随机的插入、覆盖、删除、查找；
+  {
+    M m;
+    std::unordered_map<uint64_t, double> ref;
+    srand(1);
+    for (int round = 0; round < 200000; ++round) {
+      const uint64_t k = rand() % 5000;
+      switch (rand() % 4) {
+        case 0:
+        case 1: {
+          auto [it, inserted] = m.insert(k, round);
+          auto r = ref.insert({k, round});
+          assert(inserted == r.second && it->first == k && it->second == r.first->second);
+          break;
+        }
+        case 2: {
+          const size_t erased = m.erase(k);
+          const size_t expected = ref.erase(k);
+          assert(erased == expected);
+          break;
+        }
+        default: {
+          auto it = m.find(k);
+          auto r = ref.find(k);
+          assert((it == m.end()) == (r == ref.end()));
+          if (r != ref.end()) assert(it->second == r->second);
+        }
+      }
+      assert(m.size() == ref.size());
+    }
+    // 迭代恰好覆盖所有元素一次；
+    size_t n = 0;
+    for (auto& [k, v] : m) {
+      assert(ref.at(k) == v);
+      ++n;
+    }
+    assert(n == ref.size());
+    const M& cm = m;
+    n = 0;
+    for (auto it = cm.begin(); it != cm.end(); ++it) ++n;
+    assert(n == ref.size());
+
+    // 负载因子不超过7/8；
+    assert(m.size() * 8 <= m.capacity() * 7);
+  }
+
+  // 增长：rehash到新的Layout块；
+  {
+    M m;
+    for (uint64_t i = 0; i < 100000; ++i) m[i * 7919] = i;
+    assert(m.size() == 100000);
+    assert(((m.capacity() + 1) & m.capacity()) == 0);
+    for (uint64_t i = 0; i < 100000; ++i) assert(m.find(i * 7919)->second == i);
+    assert(!m.contains(1));
+
+    // reserve之后插入不再rehash；
+    M r;
+    r.reserve(1000);
+    const size_t cap = r.capacity();
+    for (uint64_t i = 0; i < 1000; ++i) r[i] = i;
+    assert(r.capacity() == cap);
+
+    // move；
+    M moved = std::move(m);
+    assert(moved.size() == 100000 && m.size() == 0 && m.find(7919) == m.end());
+    moved.clear();
+    assert(moved.empty() && moved.find(0) == moved.end());
+  }
+
+  // 反复插入删除：墓碑不会让表无限增长；
+  {
+    M m;
+    for (uint64_t i = 0; i < 100000; ++i) {
+      m[i] = i;
+      m.erase(i);
+    }
+    assert(m.empty() && m.capacity() <= 31);
+  }
+
+  // 删掉连续的一段key之后迭代：会遇到整个group都是空或者已删除的slot，
+  // AVX2下一个group是32个slot；
+  {
+    FlatHashMap<uint64_t, uint64_t> m;
+    for (uint64_t i = 0; i < 10000; ++i) m[i] = i;
+    for (uint64_t i = 100; i < 9900; ++i) m.erase(i);
+    uint64_t count = 0, sum = 0;
+    for (const auto& [k, v] : m) {
+      assert(k == v && (k < 100 || k >= 9900));
+      ++count;
+      sum += k;
+    }
+    assert(count == 200 && count == m.size());
+    assert(sum == 99 * 100 / 2 + (9900 + 9999) * 100 / 2);
+  }
+
+  // 非平凡的类型，退化的hash；
+  {
+    FlatHashMap<int, std::string, BadHash> m;
+    for (int i = 0; i < 300; ++i) m[i] = std::to_string(i);
+    for (int i = 0; i < 300; i += 2) {
+      const size_t erased = m.erase(i);
+      assert(erased == 1);
+    }
+    for (int i = 0; i < 300; ++i) assert(m.contains(i) == (i % 2 == 1));
+    assert(m.find(299)->second == "299");
+    FlatHashMap<std::string, int> s;
+    s["hello"] = 1;
+    s.try_emplace("world", 2);
+    assert(s["hello"] + s["world"] == 3 && s.size() == 2);
+  }
+
+  //打印：group width 16
+  std::cout << "group width " << fi::kGroupWidth << std::endl;
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "aligned_alloc.h"
+#include "jagged_layout.h"
+
+using namespace absl::container_internal;
+
+int main()
+{
+  {
+    // 邻接表：3个顶点，每个顶点的邻居个数不同；
+    std::vector<std::vector<int>> adj = {{1, 2}, {}, {0, 1, 2}};
+
+    //    +---------+---------+---------------------+-------------------+
+    //    | rows=3  | values=5| offsets: 0 2 2 5    | data: 1 2 0 1 2   |
+    //    +---------+---------+---------------------+-------------------+
+    //    @0        @8        @16                   @48
+    using J = JaggedLayout<int>;
+    assert(J::AllocSize(3, 5) == 48 + 5 * sizeof(int));
+    unsigned char* p = J::Create(adj);
+
+    J g(p);
+    assert(g.size() == 3);
+    assert(g.num_values() == 5);
+    assert(g.RowSize(0) == 2);
+    assert(g.RowSize(1) == 0);
+    assert(g.Row(1).empty());
+    assert(g.Row(2).data()[2] == 2);
+    assert(g.Offsets().data()[3] == 5);
+
+    //打印：
+    //  0: 1 2
+    //  1:
+    //  2: 0 1 2
+    for (size_t i = 0; i < g.size(); ++i) {
+      std::cout << i << ":";
+      for (int v : g.Row(i)) std::cout << " " << v;
+      std::cout << std::endl;
+    }
+
+    // offsets是相对的，整块拷贝到别的地址（等价于写文件再mmap回来）后可直接使用；
+    unsigned char* q =
+        (unsigned char*)aligned_alloc_posix(J::Alignment(), g.AllocSize());
+    memcpy(q, p, g.AllocSize());
+    J::Destroy(p);
+
+    J h(q);
+    assert(h.size() == 3);
+    assert(h.Row(0).size() == 2 && h.Row(0).data()[1] == 2);
+    assert(h.Row(2).data()[0] == 0);
+    free(q);
+  }
+
+  {
+    // N个字符串；
+    std::vector<std::string> words = {"hello", "", "jagged", "layout"};
+    using J = JaggedLayout<char>;
+    unsigned char* p = J::Create(words);
+    J w(p);
+    assert(w.size() == 4);
+    assert(w.num_values() == 17);
+
+    //打印：hello||jagged|layout|
+    for (size_t i = 0; i < w.size(); ++i) {
+      auto row = w.Row(i);
+      std::cout << std::string(row.data(), row.size()) << "|";
+    }
+    std::cout << std::endl;
+    J::Destroy(p);
+  }
+
+  {
+    // 没有行；
+    std::vector<std::vector<double>> empty;
+    unsigned char* p = JaggedLayout<double>::Create(empty);
+    JaggedLayout<double> e(p);
+    assert(e.size() == 0);
+    assert(e.num_values() == 0);
+    JaggedLayout<double>::Destroy(p);
+  }
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arena.h"
+#include "layout.h"
+#include "mpmc_queue.h"
+#include "work_stealing.h"
+
+using namespace absl::container_internal;
+
+// 每条记录：uint64_t[1]存储id，uint32_t[1]存储长度，char[n]；
+using L = Layout<uint64_t, uint32_t, char>;
+
+int main()
+{
+  {
+    // Arena：对齐与线程本地chunk；
+    Arena arena(4096);
+    unsigned char* a = arena.Allocate(L(1, 1, 3));
+    unsigned char* b = arena.Allocate(L(1, 1, 3));
+    assert(reinterpret_cast<uintptr_t>(a) % L::Alignment() == 0);
+    assert(b == a + 16);  // 同一个chunk中紧挨着
+    unsigned char* c = arena.Allocate(10, 64);
+    assert(reinterpret_cast<uintptr_t>(c) % 64 == 0);
+    unsigned char* big = arena.Allocate(100000, 8);  // 单独的chunk
+    memset(big, 0, 100000);
+    assert(arena.bytes_reserved() >= 4096 + 100000);
+  }
+
+  {
+    // 单线程：批量入队/出队，满/空；
+    MpmcQueue<int> q(8);
+    int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int out[10];
+    size_t k = q.DequeueBatch(out, 10);
+    assert(k == 0);
+    k = q.EnqueueBatch(in, 5);
+    assert(k == 5);
+    k = q.EnqueueBatch(in + 5, 5);
+    assert(k == 3);  // 只剩3个空位
+    const bool full = !q.Enqueue(100);
+    assert(full);
+    k = q.DequeueBatch(out, 4);
+    assert(k == 4);
+    assert(out[0] == 0 && out[3] == 3);
+    k = q.EnqueueBatch(in + 8, 2);
+    assert(k == 2);
+    k = q.DequeueBatch(out, 10);
+    assert(k == 6);
+    assert(out[0] == 4 && out[3] == 7 && out[5] == 9);
+  }
+
+  {
+    // 单线程：deque的LIFO/FIFO两端，以及扩容；
+    WorkStealingDeque<int> d(4);
+    for (int i = 0; i < 10; ++i) d.Push(i);
+    int x;
+    bool ok = d.Steal(&x);
+    assert(ok && x == 0);
+    ok = d.Pop(&x);
+    assert(ok && x == 9);
+    assert(d.size() == 8);
+    while (d.Pop(&x)) {
+    }
+    ok = d.Steal(&x);
+    assert(!ok);
+  }
+
+  {
+    // 多生产者、多消费者：每条记录恰好被处理一次；
+    const size_t producers = 4, consumers = 4, per_producer = 50000;
+    const size_t total = producers * per_producer;
+    Arena arena;
+    MpmcQueue<unsigned char*> queue(1024);
+    StealingConsumers<unsigned char*> group(queue, consumers);
+    std::vector<std::atomic<uint8_t>> seen(total);
+    std::atomic<size_t> done{0};
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < producers; ++t) {
+      threads.emplace_back([&, t] {
+        unsigned char* batch[16];
+        size_t n = 0;
+        for (size_t i = 0; i < per_producer; ++i) {
+          const uint64_t id = t * per_producer + i;
+          const L layout(1, 1, id % 13);
+          unsigned char* p = arena.Allocate(layout);
+          *layout.Pointer<0>(p) = id;
+          *layout.Pointer<1>(p) = id % 13;
+          memset(layout.Pointer<2>(p), 'x', id % 13);
+          batch[n++] = p;
+          if (n == 16 || i + 1 == per_producer) {
+            for (size_t k = 0; k < n;) {
+              size_t m = queue.EnqueueBatch(batch + k, n - k);
+              if (m == 0) std::this_thread::yield();
+              k += m;
+            }
+            n = 0;
+          }
+        }
+      });
+    }
+    for (size_t w = 0; w < consumers; ++w) {
+      threads.emplace_back([&, w] {
+        unsigned char* p;
+        while (done.load(std::memory_order_relaxed) < total) {
+          if (!group.Next(w, &p)) {
+            std::this_thread::yield();
+            continue;
+          }
+          constexpr auto partial = L::Partial(1, 1);
+          uint64_t id = *partial.Pointer<0>(p);
+          uint32_t n = *partial.Pointer<1>(p);
+          assert(n == id % 13);
+          assert(L(1, 1, n).Slice<2>(p).size() == n);
+          const uint8_t before = seen[id].fetch_add(1);
+          assert(before == 0);
+          done.fetch_add(1, std::memory_order_relaxed);
+        }
+      });
+    }
+    for (auto& t : threads) t.join();
+    for (size_t i = 0; i < total; ++i) assert(seen[i].load() == 1);
+
+    //打印：200000 records, each consumed once
+    std::cout << total << " records, each consumed once" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <utility>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+
+using namespace absl::container_internal;
+
+// 子记录：uint32_t[1], float[3], char[1]
+//
+//     offset:0   offset:4                 offset:16
+//      ^          ^                        ^
+//      +----------+------------------------+------+////////+
+//      | id       |  xyz (3 floats)        | flag |////////|
+//      +----------+------------------------+------+////////+
+//                                                    ^
+//                                                    |
+//                                   3B-padding，使数组中下一个Point对齐到4
+using Point =
+    SubLayout<Layout<Field<"id", uint32_t>, Field<"xyz", float>, char>, 1, 3, 1>;
+
+// 整个消息：size_t[1]存储points个数，size_t[1]存储weights个数，Point[n]，double[m]
+using Message = Layout<size_t, size_t, Point, double>;
+
+unsigned char* Create(size_t n, size_t m)
+{
+  const Message layout(1, 1, n, m);
+  unsigned char* p =
+      (unsigned char*)aligned_alloc_posix(Message::Alignment(), layout.AllocSize());
+  *layout.Pointer<0>(p) = n;
+  *layout.Pointer<1>(p) = m;
+
+  Point* points = layout.Pointer<Point>(p);
+  for (size_t i = 0; i < n; ++i) {
+    *points[i].Pointer<"id">() = i;
+    float* xyz = points[i].Pointer<"xyz">();
+    xyz[0] = i + 0.1f;
+    xyz[1] = i + 0.2f;
+    xyz[2] = i + 0.3f;
+    *points[i].Pointer<2>() = 'a' + i;
+  }
+  double* weights = layout.Pointer<double>(p);
+  for (size_t i = 0; i < m; ++i) weights[i] = i * 1.5;
+  return p;
+}
+
+int main()
+{
+  // 子记录的offset和大小都是编译期常量；
+  static_assert(alignof(Point) == 4);
+  static_assert(sizeof(Point) == 20);
+  static_assert(Point::kSize == 20);
+  static_assert(Point::Offset<0>() == 0);
+  static_assert(Point::Offset<"xyz">() == 4);
+  static_assert(Point::Offset<2>() == 16);
+  static_assert(Point::Size<1>() == 3);
+
+  // 外层layout把Point当普通元素类型：
+  //   size_t[1] @0, size_t[1] @8, Point[2] @16, double[3] @56
+  constexpr Message layout(1, 1, 2, 3);
+  static_assert(layout.Offset<2>() == 16);
+  static_assert(layout.Offset<3>() == 56);
+  static_assert(layout.AllocSize() == 80);
+
+  unsigned char* p = Create(2, 3);
+
+  // 外层Pointer<N>与内层Pointer<M>组合，等价于常量偏移：
+  constexpr auto partial = Message::Partial(1, 1);
+  size_t n = *partial.Pointer<0>(p);
+  size_t m = *partial.Pointer<1>(p);
+  assert(n == 2 && m == 3);
+
+  const Message full(1, 1, n, m);
+  const Point* points = full.Pointer<2>((const unsigned char*)p);
+  assert((const void*)points[1].Pointer<"xyz">() == (const void*)(p + 16 + 20 + 4));
+
+  //打印：
+  //  0 a 0.1 0.2 0.3
+  //  1 b 1.1 1.2 1.3
+  for (size_t i = 0; i < n; ++i) {
+    std::cout << *points[i].Pointer<0>() << " " << *points[i].Pointer<2>();
+    for (float f : points[i].Slice<1>()) std::cout << " " << f;
+    std::cout << std::endl;
+  }
+
+  //打印：0 1.5 3
+  for (double d : full.Slice<3>(p)) std::cout << d << " ";
+  std::cout << std::endl;
+
+  // 嵌套可以继续：子记录中再嵌套子记录；
+  using Pair = SubLayout<Layout<Point, Aligned<uint64_t, 32>>, 2, 1>;
+  static_assert(alignof(Pair) == 32);
+  static_assert(Pair::Offset<1>() == 64);
+  static_assert(sizeof(Pair) == 96);
+
+  free(p);
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "aligned_alloc.h"
+#include "layout.h"
+#include "parallel_columns.h"
+#include "thread_pool.h"
+
+using namespace absl::container_internal;
+
+// 按列存储的订单：id，价格，数量，三列都从cache line开始；
+using L = Layout<Aligned<uint64_t, 64>, Aligned<double, 64>, Aligned<int32_t, 64>>;
+
+int main()
+{
+  // 每行64的倍数字节：uint64_t和double需要8行，int32_t需要16行；
+  static_assert(RowQuantum<uint64_t, double, int32_t>() == 16);
+  static_assert(RowQuantum<char>() == 64);
+
+  const size_t n = 100003;  // 不是chunk的整数倍
+  const L layout(n, n, n);
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+  auto rows = layout.Zip<0, 1, 2>(p);
+
+  for (size_t workers : {1, 3, 4}) {
+    ThreadPool pool(workers);
+
+    // for_each：写入所有列；
+    std::mt19937_64 rng(workers);
+    std::vector<uint64_t> ids(n);
+    for (auto& id : ids) id = rng() % 50000;  // 有重复的key
+    ParallelForEach(pool, layout.Zip<0, 1, 2>(p),
+                    [&](uint64_t& id, double& price, int32_t& qty) {
+                      const size_t i = &id - layout.Pointer<0>(p);
+                      id = ids[i];
+                      price = static_cast<double>(i);  // 原始行号
+                      qty = static_cast<int32_t>(id % 7);
+                    });
+    assert(layout.Pointer<0>(p)[n - 1] == ids[n - 1]);
+
+    // transform：输出到另一列；
+    ParallelTransform(pool, layout.Zip<0>(p), layout.Pointer<2>(p),
+                      [](uint64_t id) { return static_cast<int32_t>(id % 5); });
+    for (size_t i = 0; i < n; i += 1000) assert(layout.Pointer<2>(p)[i] == int32_t(ids[i] % 5));
+
+    // reduce：结果与线程数无关；
+    const uint64_t sum = ParallelReduce(pool, layout.Zip<0, 2>(p), uint64_t{0},
+                                        [](uint64_t id, int32_t q) { return id + q; },
+                                        std::plus<>());
+    uint64_t expect = 0;
+    for (size_t i = 0; i < n; ++i) expect += ids[i] + ids[i] % 5;
+    assert(sum == expect);
+
+    // sort_by_key：稳定，其它列跟着移动；
+    ParallelSortByKey<0>(pool, rows);
+    for (size_t i = 0; i < n; ++i) {
+      const uint64_t id = layout.Pointer<0>(p)[i];
+      const double row = layout.Pointer<1>(p)[i];
+      assert(ids[static_cast<size_t>(row)] == id);
+      assert(layout.Pointer<2>(p)[i] == int32_t(id % 5));
+      if (i > 0) {
+        const uint64_t prev = layout.Pointer<0>(p)[i - 1];
+        assert(prev < id || (prev == id && layout.Pointer<1>(p)[i - 1] < row));
+      }
+    }
+
+    // partition：稳定，返回满足条件的行数；
+    const size_t evens = ParallelPartition(pool, rows,
+        [](uint64_t id, double, int32_t) { return id % 2 == 0; });
+    const size_t expect_evens = std::count_if(ids.begin(), ids.end(),
+                                              [](uint64_t id) { return id % 2 == 0; });
+    assert(evens == expect_evens);
+    for (size_t i = 0; i < n; ++i) {
+      const uint64_t id = layout.Pointer<0>(p)[i];
+      assert((id % 2 == 0) == (i < evens));
+      if (i > 0 && i != evens) assert(layout.Pointer<0>(p)[i - 1] <= id);  // 组内仍有序
+    }
+  }
+
+  free(p);
+
+  //打印：parallel ok
+  std::cout << "parallel ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "portable_layout.h"
+
+using namespace absl::container_internal;
+
+int main()
+{
+  // ByteSwap：SSSE3的pshufb路径（16字节一组）+ 尾部的标量路径；
+  {
+    std::vector<uint32_t> a(37), b(37);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = 0x01020304u + i;
+    ByteSwap<4>(b.data(), a.data(), a.size());
+    for (size_t i = 0; i < a.size(); ++i) assert(b[i] == __builtin_bswap32(a[i]));
+    ByteSwap<4>(b.data(), b.data(), b.size());  // 原地
+    assert(a == b);
+
+    std::vector<uint64_t> c = {0x0102030405060708ull, 1, 2};
+    ByteSwap<8>(c.data(), c.data(), c.size());
+    assert(c[0] == 0x0807060504030201ull && c[1] == (1ull << 56));
+
+    uint16_t s[9] = {0x1234, 0, 0, 0, 0, 0, 0, 0, 0xabcd};
+    ByteSwap<2>(s, s, 9);
+    assert(s[0] == 0x3412 && s[8] == 0xcdab);
+  }
+
+  // uint8_t[3], double[2], int16_t[3]：offset只取决于元素的size，与alignof无关；
+  using P = PortableLayout<uint8_t, double, int16_t>;
+  std::vector<uint8_t> u = {1, 2, 3};
+  std::vector<double> d = {1.5, -2.0};
+  std::vector<int16_t> s = {-1, 256, 7};
+  const P::L layout = P::MakeLayout(3, 2, 3);
+  assert(layout.Offset<1>() == 32);  // 4个uint64_t的header
+  assert(layout.Offset<2>() == 40);
+  assert(layout.Offset<3>() == 56);
+  assert(P::AllocSize(3, 2, 3) == 62);
+
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(P::Alignment(), P::AllocSize(3, 2, 3));
+  memset(p, 0, P::AllocSize(3, 2, 3));
+  P::Build(p, u, d, s);
+
+  // 固定的字节序列：任何host写出的都一样；
+  const unsigned char golden[62] = {
+      'P', 'L', 'Y', 'T', 1, 0, 0, 0,                  // magic, version
+      3, 0, 0, 0, 0, 0, 0, 0,                          // 3个uint8_t
+      2, 0, 0, 0, 0, 0, 0, 0,                          // 2个double
+      3, 0, 0, 0, 0, 0, 0, 0,                          // 3个int16_t
+      1, 2, 3, 0, 0, 0, 0, 0,                          // uint8_t + padding
+      0, 0, 0, 0, 0, 0, 0xf8, 0x3f,                    // 1.5
+      0, 0, 0, 0, 0, 0, 0, 0xc0,                       // -2.0
+      0xff, 0xff, 0x00, 0x01, 0x07, 0x00,              // -1, 256, 7
+  };
+  assert(memcmp(p, golden, sizeof(golden)) == 0);
+
+  P view(p);
+  assert(view.valid());
+  assert(view.Size<0>() == 3 && view.Size<1>() == 2 && view.Size<2>() == 3);
+  assert(view.AllocSize() == 62);
+  auto doubles = view.Slice<1>();  // 小端host上不拷贝
+  assert(doubles.data() == (const double*)(p + 40));
+  assert(doubles.data()[1] == -2.0);
+  int16_t out[3];
+  view.Load<2>(out);
+  assert(out[0] == -1 && out[1] == 256 && out[2] == 7);
+
+  // 魔数不对；
+  p[0] = 'X';
+  assert(!P(p).valid());
+  free(p);
+
+  // Bits<K>的word也是小端，对齐到8；
+  {
+    using B = PortableLayout<uint16_t, Bits<1>>;
+    std::vector<uint16_t> ids = {7};
+    std::vector<uint64_t> words(2);
+    BitSpan<1, uint64_t> flags(words.data(), 70);
+    flags[0] = 1;
+    flags[69] = 1;
+    static_assert(B::AllocSize(1, 70) == 24 + 8 + 16);  // header, uint16_t + padding, 2个word
+    unsigned char* q = (unsigned char*)aligned_alloc_posix(B::Alignment(), B::AllocSize(1, 70));
+    B::Build(q, ids, flags);
+    B v(q);
+    assert(v.valid() && v.Size<1>() == 70);
+    assert(v.Slice<1>().Count() == 2 && v.Slice<1>().Select(1) == 69);
+    assert(q[24] == 7 && q[32] == 1 && q[40] == 0x20);
+    free(q);
+  }
+
+  //打印：portable block: 62 bytes
+  std::cout << "portable block: " << view.AllocSize() << " bytes" << std::endl;
+  return 0;
+}
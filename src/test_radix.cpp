@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "aligned_alloc.h"
+#include "layout.h"
+#include "radix_sort.h"
+#include "thread_pool.h"
+
+using namespace absl::container_internal;
+
+// 第0列是key，第1列是原始行号，第2列由key决定：排序后检查三列是否一起移动，
+// 以及结果是否与std::stable_sort一致（稳定）。
+template <class Key, class Sort>
+void Check(const std::vector<Key>& keys, Sort sort)
+{
+  using L = Layout<Aligned<Key, 64>, Aligned<uint32_t, 64>, Aligned<double, 64>>;
+  const size_t n = keys.size();
+  const L layout(n, n, n);
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+  for (size_t i = 0; i < n; ++i) {
+    layout.template Pointer<0>(p)[i] = keys[i];
+    layout.template Pointer<1>(p)[i] = static_cast<uint32_t>(i);
+    layout.template Pointer<2>(p)[i] = static_cast<double>(keys[i]) * 2;
+  }
+
+  sort(layout.template Zip<0, 1, 2>(p));
+
+  std::vector<uint32_t> expect(n);
+  std::iota(expect.begin(), expect.end(), 0);
+  std::stable_sort(expect.begin(), expect.end(),
+                   [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+  for (size_t i = 0; i < n; ++i) {
+    assert(layout.template Pointer<1>(p)[i] == expect[i]);
+    assert(layout.template Pointer<0>(p)[i] == keys[expect[i]]);
+    assert(layout.template Pointer<2>(p)[i] == static_cast<double>(keys[expect[i]]) * 2);
+  }
+  free(p);
+}
+
+template <class Sort>
+void CheckAll(Sort sort)
+{
+  std::mt19937_64 rng(42);
+  const size_t n = 200003;  // 不是16行的整数倍
+
+  // 有大量重复的key：检查稳定性；
+  std::vector<uint64_t> u64(n);
+  for (auto& k : u64) k = rng() % 5000;
+  Check(u64, sort);
+  // 全部8个字节都有效；
+  for (auto& k : u64) k = rng();
+  Check(u64, sort);
+  // 只有中间的字节不同：其它趟被跳过，趟数为奇数时要拷回；
+  for (auto& k : u64) k = 0x1100000000000022 | ((rng() & 0xff) << 24);
+  Check(u64, sort);
+  // 所有key相同：一趟都不做；
+  std::fill(u64.begin(), u64.end(), 7);
+  Check(u64, sort);
+
+  // 有符号数：负数在前；
+  std::vector<int32_t> i32(n);
+  for (auto& k : i32) k = static_cast<int32_t>(rng() % 2001) - 1000;
+  Check(i32, sort);
+
+  // 浮点数：负数按相反的位序；
+  std::vector<double> f64(n);
+  for (auto& k : f64) k = std::uniform_real_distribution<double>(-1e6, 1e6)(rng);
+  f64[0] = 0.0;
+  f64[1] = -1.5;
+  Check(f64, sort);
+
+  // 单字节key，以及很少的行；
+  std::vector<uint8_t> u8(n);
+  for (auto& k : u8) k = static_cast<uint8_t>(rng());
+  Check(u8, sort);
+  Check(std::vector<uint8_t>{3, 1, 2}, sort);
+  Check(std::vector<uint8_t>{}, sort);
+}
+
+int main()
+{
+  // 浮点数的位序与数值的大小顺序一致；
+  using radix_internal::RadixBits;
+  assert(RadixBits(-2.0) < RadixBits(-1.0));
+  assert(RadixBits(-1.0) < RadixBits(-0.0));
+  assert(RadixBits(-0.0) < RadixBits(0.0));
+  assert(RadixBits(-0.0f) < RadixBits(0.0f) && RadixBits(0.0f) < RadixBits(1.0f));
+  assert(RadixBits(1.0f) < RadixBits(2.0f));
+  assert(RadixBits(int8_t{-128}) == 0 && RadixBits(int8_t{127}) == 255);
+
+  CheckAll([](auto rows) { RadixSortByKey<0>(rows); });
+  for (size_t workers : {1, 3, 4}) {
+    ThreadPool pool(workers);
+    CheckAll([&](auto rows) { ParallelRadixSortByKey<0>(pool, rows); });
+  }
+
+  //打印：radix ok
+  std::cout << "radix ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "seqlock.h"
+
+using namespace absl::container_internal;
+
+// 分片统计：计数器，延迟，直方图；
+using Stats = Layout<uint64_t, double, uint32_t>;
+
+int main()
+{
+  {
+    // 单线程：原地更新，读取指定的数组或整个blob；
+    SeqlockBlob<Stats> stats(Stats(4, 3, 5));
+    assert(stats.version() == 0 && stats.size() == Stats(4, 3, 5).AllocSize());
+    stats.Update([&](unsigned char* p) {
+      stats.layout().Pointer<0>(p)[2] = 7;
+      stats.layout().Pointer<1>(p)[1] = 1.5;
+      stats.layout().Pointer<2>(p)[4] = 9;
+    });
+    assert(stats.version() == 1);
+
+    uint64_t counters[4];
+    uint32_t histogram[5];
+    stats.Read<0, 2>(counters, histogram);
+    assert(counters[2] == 7 && counters[0] == 0 && histogram[4] == 9);
+    double latencies[3];
+    assert(stats.TryRead<1>(latencies) && latencies[1] == 1.5);
+
+    alignas(8) unsigned char copy[128];
+    assert(stats.size() <= sizeof(copy));
+    stats.ReadBlob(copy);
+    assert(stats.layout().Pointer<0>(copy)[2] == 7);
+    assert(stats.layout().Pointer<2>(copy)[4] == 9);
+  }
+
+  {
+    // 多线程：一个写者，多个读者；读到的快照内部必须一致：
+    // 计数器都等于v，延迟都等于-v；
+    using L = Layout<uint64_t, double>;
+    SeqlockBlob<L> stats(L(32, 32));
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+      readers.emplace_back([&] {
+        uint64_t counters[32];
+        double latencies[32];
+        uint64_t last = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+          stats.Read<0, 1>(counters, latencies);
+          for (int i = 0; i < 32; ++i) {
+            assert(counters[i] == counters[0]);
+            assert(latencies[i] == -static_cast<double>(counters[0]));
+          }
+          assert(counters[0] >= last);  // 版本不回退
+          last = counters[0];
+        }
+      });
+    }
+    const uint64_t kUpdates = 200000;
+    for (uint64_t v = 1; v <= kUpdates; ++v) {
+      stats.Update([&](unsigned char* p) {
+        for (int i = 0; i < 32; ++i) {
+          stats.layout().Pointer<0>(p)[i] = v;
+          stats.layout().Pointer<1>(p)[i] = -static_cast<double>(v);
+        }
+      });
+    }
+    stop = true;
+    for (auto& th : readers) th.join();
+    assert(stats.version() == kUpdates);
+  }
+
+  //打印：seqlock ok
+  std::cout << "seqlock ok" << std::endl;
+  return 0;
+}
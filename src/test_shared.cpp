@@ -0,0 +1,74 @@
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "shared_blob.h"
+
+using namespace absl::container_internal;
+
+using L = Layout<size_t, size_t, float, double>;
+
+int main()
+{
+  {
+    // 引用计数与blob在同一次分配中，blob按L::Alignment()对齐；
+    using B = SharedBlob<L>;
+    static_assert(sizeof(B) == sizeof(L) + sizeof(void*));
+    B a = B::Make(L(1, 1, 3, 4));
+    assert(a.use_count() == 1 && a.size() == L(1, 1, 3, 4).AllocSize());
+    assert(reinterpret_cast<uintptr_t>(a.data()) % L::Alignment() == 0);
+    assert(a.Slice<3>().size() == 4 && a.Slice<3>().data()[0] == 0.0);
+
+    // 唯一持有：原地修改，不复制；
+    const unsigned char* before = a.data();
+    unsigned char* p = a.MutableCopy();
+    assert(p == before);
+    *a.layout().Pointer<0>(p) = 3;
+    a.layout().Pointer<3>(p)[1] = 5.5;
+
+    // 共享：复制只是加计数；
+    B b = a;
+    assert(a.use_count() == 2 && b.data() == a.data());
+
+    // 写时复制：a移到副本上，b看到的内容不变；
+    p = a.MutableCopy();
+    assert(p != b.data() && a.use_count() == 1 && b.use_count() == 1);
+    a.layout().Pointer<3>(p)[1] = 6.6;
+    assert(b.Slice<3>().data()[1] == 5.5 && *b.Pointer<0>() == 3);
+    assert(a.Slice<3>().data()[1] == 6.6 && *a.Pointer<0>() == 3);
+
+    // 移动与赋值；
+    B c = std::move(b);
+    assert(!b && b.use_count() == 0 && c.use_count() == 1);
+    c = a;
+    assert(a.use_count() == 2 && c.data() == a.data());
+  }
+
+  {
+    // 多线程并发复制、销毁句柄；
+    using B = SharedBlob<L>;
+    B blob = B::Make(L(1, 1, 100, 100));
+    float* floats = blob.layout().Pointer<2>(blob.MutableCopy());
+    for (int i = 0; i < 100; ++i) floats[i] = i;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([snapshot = blob] {
+        for (int i = 0; i < 10000; ++i) {
+          B copy = snapshot;
+          assert(copy.Slice<2>().data()[99] == 99.0f);
+        }
+      });
+    }
+    for (auto& th : threads) th.join();
+    assert(blob.use_count() == 1);
+  }
+
+  //打印：shared ok
+  std::cout << "shared ok" << std::endl;
+  return 0;
+}
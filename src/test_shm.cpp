@@ -0,0 +1,100 @@
+#include <iostream>
+#include <utility>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "layout.h"
+#include "relative_ptr.h"
+#include "shm_segment.h"
+
+using namespace absl::container_internal;
+using namespace absl::container_internal::internal_layout;
+
+// 根blob：size_t[1]存储条目数，RelativePtr<Entry>[n]指向各个条目blob；
+using Root = Layout<size_t, RelativePtr<unsigned char>>;
+
+// 条目blob：和test_serialize.cpp中的MyCompactFoo一样，size_t[1], float[n]；
+using Entry = Layout<size_t, float>;
+
+static_assert(IsLegalElementType<RelativePtr<unsigned char>>::value);
+static_assert(sizeof(RelativePtr<unsigned char>) == 8);
+
+// 读者：只通过相对指针访问，不依赖映射地址；
+float Sum(const ShmSegment& seg)
+{
+  const unsigned char* root = seg.Root();
+  size_t n = *Root::Partial(1).Pointer<0>(root);
+  const Root layout(1, n);
+  const RelativePtr<unsigned char>* entries = layout.Pointer<1>(root);
+
+  float sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const unsigned char* e = entries[i].get();
+    assert(seg.Contains(e));
+    size_t m = *Entry::Partial(1).Pointer<0>(e);
+    for (float f : Entry(1, m).Slice<1>(e)) sum += f;
+  }
+  return sum;
+}
+
+int main()
+{
+  ShmSegment seg = ShmSegment::Create("test_shm", 1 << 16);
+  assert(seg.valid());
+
+  // 写者：分配3个条目blob和1个根blob；
+  const size_t n = 3;
+  const Root root_layout(1, n);
+  unsigned char* root = seg.Allocate(root_layout);
+  assert(reinterpret_cast<uintptr_t>(root) % Root::Alignment() == 0);
+  *root_layout.Pointer<0>(root) = n;
+  RelativePtr<unsigned char>* entries = root_layout.Pointer<1>(root);
+
+  for (size_t i = 0; i < n; ++i) {
+    const Entry layout(1, i + 1);
+    unsigned char* e = seg.Allocate(layout);
+    *layout.Pointer<0>(e) = i + 1;
+    float* floats = layout.Pointer<1>(e);
+    for (size_t j = 0; j <= i; ++j) floats[j] = 1.5f;
+    entries[i] = e;
+    assert(entries[i].get() == e);
+  }
+  seg.SetRoot(root);
+
+  // 1+2+3个1.5
+  assert(Sum(seg) == 9.0f);
+
+  // 同一个segment再映射一次，地址不同，但内容（包括相对指针）仍然有效；
+  ShmSegment other = ShmSegment::Attach(dup(seg.fd()));
+  assert(other.valid());
+  assert(other.base() != seg.base());
+  assert(other.Root() - other.base() == seg.Root() - seg.base());
+  assert(Sum(other) == 9.0f);
+
+  // 在另一个进程中使用；
+  pid_t pid = fork();
+  if (pid == 0) {
+    ShmSegment child = ShmSegment::Attach(dup(seg.fd()));
+    _exit(child.valid() && Sum(child) == 9.0f ? 0 : 1);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  // 复制RelativePtr会重新计算偏移，指向同一个目标；
+  RelativePtr<unsigned char> copy = entries[1];
+  assert(copy.get() == entries[1].get());
+  assert(copy.offset() != entries[1].offset());
+
+  // 空间不足时返回nullptr；
+  unsigned char* too_big = seg.Allocate(1 << 20, 8);
+  assert(too_big == nullptr);
+
+  //打印：used 148 of 65536 bytes
+  std::cout << "used " << seg.used() << " of " << seg.size() << " bytes" << std::endl;
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "arena.h"
+#include "skiplist.h"
+
+using namespace absl::container_internal;
+
+int main()
+{
+  {
+    // 单线程：与std::map对比；
+    Arena arena;
+    ConcurrentSkipList<int64_t, int64_t> s(arena);
+    std::map<int64_t, int64_t> m;
+    assert(s.begin() == s.end() && s.Find(1) == nullptr);
+    std::mt19937_64 rng(1);
+    for (int i = 0; i < 20000; ++i) {
+      const int64_t k = rng() % 50000;
+      const bool inserted = s.Insert(k, k * 3);
+      const bool expected = m.emplace(k, k * 3).second;
+      assert(inserted == expected);
+    }
+    assert(s.size() == m.size());
+    for (int64_t k = 0; k < 50000; ++k) {
+      const int64_t* v = s.Find(k);
+      assert((v != nullptr) == m.contains(k));
+      if (v != nullptr) assert(*v == k * 3);
+    }
+    // 有序遍历；
+    auto it = s.begin();
+    for (auto& [k, v] : m) {
+      assert(it != s.end() && it.key() == k && it.value() == v);
+      ++it;
+    }
+    assert(it == s.end());
+    // LowerBound；
+    for (int64_t k : {-1L, 0L, 777L, 49999L, 60000L}) {
+      auto a = s.LowerBound(k);
+      auto b = m.lower_bound(k);
+      assert((a == s.end()) == (b == m.end()));
+      if (b != m.end()) assert(a.key() == b->first);
+    }
+  }
+
+  {
+    // 节点是Layout<K, V, atomic<Node*>>(1, 1, height)块；
+    using S = ConcurrentSkipList<uint32_t, uint16_t>;
+    assert(S::NodeLayout(1, 1, 1).AllocSize() == 16);
+    assert(S::NodeLayout(1, 1, 3).AllocSize() == 32);
+  }
+
+  {
+    // 多线程：交叠的key并发插入，同时并发查找，每个key恰好插入成功一次；
+    Arena arena;
+    ConcurrentSkipList<uint64_t, uint64_t> s(arena);
+    const int kThreads = 4;
+    const uint64_t kKeys = 20000;
+    std::vector<size_t> inserted(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        std::mt19937_64 rng(t);
+        for (uint64_t i = 0; i < kKeys; ++i) {
+          const uint64_t k = (i * 7919 + t * 13) % kKeys;
+          if (s.Insert(k, k + 1)) ++inserted[t];
+          const uint64_t* v = s.Find(rng() % kKeys);
+          assert(v == nullptr || *v != 0);
+        }
+      });
+    }
+    for (auto& th : threads) th.join();
+    size_t total = 0;
+    for (size_t n : inserted) total += n;
+    assert(total == kKeys && s.size() == kKeys);
+    uint64_t expect = 0;
+    for (auto it = s.begin(); it != s.end(); ++it, ++expect) {
+      assert(it.key() == expect && it.value() == expect + 1);
+    }
+    assert(expect == kKeys);
+  }
+
+  {
+    // 多线程从空表开始插入：表的高度在两次插入之间被别的线程抬高，高出搜索
+    // 高度的那些层要从head开始。只有多核才能触发这个竞争，单核上一定通过；
+    const int kThreads = 4;
+    for (int round = 0; round < 200; ++round) {
+      Arena arena;
+      ConcurrentSkipList<uint64_t, uint64_t> s(arena);
+      std::vector<std::thread> threads;
+      for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+          for (uint64_t i = 0; i < 64; ++i) s.Insert(i * kThreads + t, i);
+        });
+      }
+      for (auto& th : threads) th.join();
+      uint64_t expect = 0;
+      for (auto it = s.begin(); it != s.end(); ++it, ++expect) {
+        assert(it.key() == expect);
+      }
+      assert(expect == 64 * kThreads);
+    }
+  }
+
+  //打印：skiplist ok
+  std::cout << "skiplist ok" << std::endl;
+  return 0;
+}
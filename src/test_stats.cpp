@@ -0,0 +1,103 @@
+#include <iostream>
+#include <utility>
+
+#include <assert.h>
+
+#include "layout.h"
+
+using namespace absl::container_internal;
+using namespace absl::container_internal::internal_layout;
+
+// 24字节、alignment为1的元素，用来制造跨cache line的元素；
+struct Rec24 {
+  char c[24];
+};
+
+// 逐个元素检查是否跨cache line，用来验证StraddlingCount的周期算法；
+size_t BruteForceStraddling(size_t offset, size_t size, size_t n, size_t line)
+{
+  size_t res = 0;
+  for (size_t i = 0; i < n; ++i) {
+    size_t begin = offset + i * size;
+    size_t end = begin + size - 1;
+    res += (begin / line != end / line);
+  }
+  return res;
+}
+
+int main()
+{
+  {
+    // char[3], 1B-padding, int[2], 4B-padding, double[4]；见test_alignment.cpp
+    using L = Layout<char, int, double>;
+    L layout(3, 2, 4);
+    auto s = layout.Stats();
+
+    assert(s.alloc_size == 48);
+    assert(s.payload_bytes == 43);
+    assert(s.padding_bytes == 5);
+    assert(s.fields[0].padding == 0);
+    assert(s.fields[1].padding == 1);
+    assert(s.fields[2].padding == 4);
+    assert(s.fields[2].offset == 16);
+    assert(s.fields[2].bytes == 32);
+
+    // double[4], int[2], char[3]没有padding；
+    assert(s.min_padding_alloc_size == 43);
+    assert(s.reorder_savings == 5);
+    // int[2]也是8字节，所以int, double, char同样没有padding，且字典序更小；
+    assert((s.min_padding_order == std::array<size_t, 3>{1, 2, 0}));
+
+    //打印：
+    //  alignment 8, alloc 48 B, payload 43 B, padding 5 B (10.4%)
+    //    #0 <char> @0 3x1 = 3 B, padding 0 B, 1 line(s), 0 straddling
+    //    #1 <int> @4 2x4 = 8 B, padding 1 B, 1 line(s), 0 straddling
+    //    #2 <double> @16 4x8 = 32 B, padding 4 B, 1 line(s), 0 straddling
+    //    min-padding order 1 2 0: alloc 43 B, saves 5 B
+    std::cout << layout.Report();
+  }
+
+  {
+    // char[3], 29B-padding, int[2], double[4]；
+    // double数组占[40, 72)，跨2个cache line，但没有元素跨cache line；
+    using L = Layout<char, Aligned<int, 32>, double>;
+    L layout(3, 2, 4);
+    auto s = layout.Stats();
+
+    assert(s.alloc_size == 72);
+    assert(s.padding_bytes == 29);
+    assert(s.fields[1].padding == 29);
+    assert(s.fields[2].cache_lines == 2);
+    assert(s.fields[2].straddling == 0);
+    assert(s.min_padding_alloc_size == 43);
+    assert(s.reorder_savings == 29);
+    std::cout << layout.Report();
+  }
+
+  {
+    // char[1], Rec24[8]：元素起始于1, 25, 49(跨), 73, 97, 121(跨), 145, 169(跨)
+    using L = Layout<char, Rec24>;
+    L layout(1, 8);
+    auto s = layout.Stats();
+    assert(s.padding_bytes == 0);
+    assert(s.fields[1].straddling == 3);
+    assert(s.fields[1].cache_lines == 4);
+    assert(s.reorder_savings == 0);
+
+    // 换成32字节的cache line；
+    auto s32 = layout.Stats(32);
+    assert(s32.fields[1].straddling == BruteForceStraddling(1, 24, 8, 32));
+    std::cout << layout.Report();
+  }
+
+  for (size_t offset = 0; offset < 70; offset += 3) {
+    for (size_t size : {1, 3, 8, 12, 24, 40, 64, 100}) {
+      for (size_t n : {0, 1, 5, 17, 100}) {
+        assert(adl_barrier::StraddlingCount(offset, size, n, 64) ==
+               BruteForceStraddling(offset, size, n, 64));
+      }
+    }
+  }
+
+  return 0;
+}
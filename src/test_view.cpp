@@ -0,0 +1,135 @@
+#include <iostream>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "layout.h"
+#include "aligned_alloc.h"
+#include "layout_view.h"
+
+using namespace absl::container_internal;
+
+// 与test_serialize.cpp相同的约定：前2个数组各存1个长度，分别是后2个数组的长度；
+using L = Layout<Field<"num_floats", size_t>, Field<"num_doubles", size_t>,
+                 Field<"floats", float>, Field<"doubles", double>>;
+
+int main()
+{
+  const L layout(1, 1, 3, 4);
+  const size_t len = layout.AllocSize();
+  assert(len == 16 + 12 + 4 + 32);
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), len + 64);
+  memset(p, 0, len + 64);
+  *layout.Pointer<"num_floats">(p) = 3;
+  *layout.Pointer<"num_doubles">(p) = 4;
+  for (size_t i = 0; i < 3; ++i) layout.Pointer<"floats">(p)[i] = i + 0.5f;
+  for (size_t i = 0; i < 4; ++i) layout.Pointer<"doubles">(p)[i] = i * 2.0;
+
+  // 合法：校验之后的访问无需再检查；
+  {
+    auto view = TryView<L>((const unsigned char*)p, len);
+    assert(view.valid() && view.error() == ViewError::kOk);
+    assert(view.Size<"floats">() == 3 && view.Size<3>() == 4);
+    assert(view.layout().AllocSize() == len);
+    float sum = 0;
+    for (float f : view.Slice<"floats">()) sum += f;
+    assert(sum == 4.5f);
+    assert(view.Pointer<"doubles">()[3] == 6.0);
+
+    // 非const的buffer得到可写的view；
+    auto mut = TryView<L>(p, len + 64);  // buffer比blob长也可以
+    assert(mut.valid());
+    mut.Pointer<"floats">()[0] = 9.5f;
+    assert(layout.Pointer<"floats">(p)[0] == 9.5f);
+  }
+
+  // buffer短了1个字节、短到连长度都放不下、为空；
+  assert(TryView<L>(p, len - 1).error() == ViewError::kTruncated);
+  assert(TryView<L>(p, 15).error() == ViewError::kTruncated);
+  assert(TryView<L>(p, 0).error() == ViewError::kTruncated);
+
+  // 没有对齐、空指针；
+  assert(TryView<L>(p + 4, len).error() == ViewError::kMisaligned);
+  assert(TryView<L>((unsigned char*)nullptr, len).error() == ViewError::kMisaligned);
+
+  // 伪造的长度：不能回绕成一个小的AllocSize；
+  *layout.Pointer<"num_doubles">(p) = (SIZE_MAX / 8) + 2;  // *8之后回绕成8
+  assert(TryView<L>(p, len).error() == ViewError::kOverflow);
+  *layout.Pointer<"num_doubles">(p) = SIZE_MAX / 16;  // 不回绕，但远超len
+  assert(TryView<L>(p, len).error() == ViewError::kTruncated);
+  *layout.Pointer<"num_doubles">(p) = 5;
+  assert(TryView<L>(p, len).error() == ViewError::kTruncated);
+  assert(TryView<L>(p, len + 8).valid());
+  *layout.Pointer<"num_doubles">(p) = 4;
+
+  // 上一个数组结束于len附近时，padding本身也要放得下：floats占满到28，doubles从32开始；
+  *layout.Pointer<"num_floats">(p) = 3;
+  *layout.Pointer<"num_doubles">(p) = 0;
+  assert(TryView<L>(p, 28).error() == ViewError::kTruncated);
+  assert(TryView<L>(p, 32).valid());
+
+  // Bits<K>数组：count * K 的溢出；
+  {
+    using B = Layout<uint32_t, Bits<3>>;
+    alignas(8) unsigned char q[16] = {};
+    const uint32_t n = 100;  // 300 bit -> 5个word
+    memcpy(q, &n, sizeof(n));
+    assert(TryView<B>(q, 8 + 32).error() == ViewError::kTruncated);
+    const uint32_t small = 21;  // 63 bit -> 1个word
+    memcpy(q, &small, sizeof(small));
+    auto view = TryView<B>(q, sizeof(q));
+    assert(view.valid() && view.Slice<1>().size() == 21);
+
+    using B64 = Layout<uint64_t, Bits<64>>;
+    alignas(8) unsigned char r[16] = {};
+    const uint64_t huge = SIZE_MAX / 32;  // *64 溢出
+    memcpy(r, &huge, sizeof(huge));
+    assert(TryView<B64>(r, sizeof(r)).error() == ViewError::kOverflow);
+  }
+
+  // 32位平台：uint64_t的count大于SIZE_MAX，不能截断成一个小的count；
+  if constexpr (sizeof(size_t) < sizeof(uint64_t)) {
+    using C = Layout<uint64_t, char>;
+    alignas(8) unsigned char q[16] = {};
+    const uint64_t count = uint64_t{SIZE_MAX} + 5;  // 截断后是4
+    memcpy(q, &count, sizeof(count));
+    assert(TryView<C>(q, sizeof(q)).error() == ViewError::kOverflow);
+  }
+
+  // CheckedOffset / CheckedAllocSize：与Offset / AllocSize相同，溢出时为nullopt；
+  {
+    static_assert(L(1, 1, 3, 4).CheckedAllocSize() == 64);
+    static_assert(L(1, 1, 3, 4).CheckedOffset<3>() == 32);
+    static_assert(L::Partial(1, 1, 3).CheckedOffset<3>() == 32);
+    static_assert(!L(1, 1, 3, SIZE_MAX / 8 + 2).CheckedAllocSize().has_value());
+    static_assert(!L(1, 1, SIZE_MAX / 4, 0).CheckedOffset<3>().has_value());
+    // AllocSize()回绕成一个很小的值，CheckedAllocSize()能发现；
+    const L bad(1, 1, 3, SIZE_MAX / 8 + 2);
+    assert(bad.AllocSize() < 64);
+    assert(!bad.CheckedAllocSize());
+    // 对齐本身溢出：最后一个数组结束于SIZE_MAX附近；
+    assert(!L(1, 1, SIZE_MAX / 4 - 4, 0).CheckedAllocSize());
+    assert(!Layout<Bits<64>>(SIZE_MAX / 32).CheckedAllocSize());
+    assert(Layout<Bits<1>>(SIZE_MAX).CheckedAllocSize() == SIZE_MAX / 64 * 8 + 8);
+
+    // 批量：无逐个分支，返回溢出的个数；
+    std::vector<L> layouts;
+    for (size_t i = 0; i < 100; ++i) layouts.push_back(L(1, 1, i, i % 7 == 0 ? SIZE_MAX / 4 : i));
+    std::vector<size_t> sizes(layouts.size());
+    assert(CheckedAllocSizes(layouts.data(), layouts.size(), sizes.data()) == 15);
+    for (size_t i = 0; i < 100; ++i) {
+      assert(sizes[i] == (i % 7 == 0 ? 0 : layouts[i].AllocSize()));
+    }
+  }
+
+  //打印：view of 64 bytes: 3 floats, 4 doubles
+  *layout.Pointer<"num_doubles">(p) = 4;
+  auto view = TryView<L>(p, len);
+  std::cout << "view of " << view.layout().AllocSize() << " bytes: " << view.Size<2>()
+            << " floats, " << view.Size<3>() << " doubles" << std::endl;
+  free(p);
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "aligned_alloc.h"
+#include "layout.h"
+
+using namespace absl::container_internal;
+
+// 按列存储的记录：id，价格，数量；
+using L = Layout<uint32_t, double, int32_t>;
+
+int main()
+{
+  const size_t n = 100;
+  const L layout(n, n, n);
+  unsigned char* p = (unsigned char*)aligned_alloc_posix(L::Alignment(), layout.AllocSize());
+
+  {
+    // range-for：按行读写多个列；
+    uint32_t i = 0;
+    for (auto [id, price, qty] : layout.Zip<0, 1, 2>(p)) {
+      id = (i * 37) % n;  // 0..99的一个排列
+      price = id * 0.5;
+      qty = -static_cast<int32_t>(id);
+      ++i;
+    }
+    assert(layout.Pointer<1>(p)[1] == 18.5 && layout.Pointer<2>(p)[1] == -37);
+
+    // 只取部分列，顺序任意；const的p得到只读的行；
+    const unsigned char* cp = p;
+    auto rows = layout.Zip<2, 0>(cp);
+    static_assert(std::is_same_v<decltype(rows[0]), ZipRef<const int32_t, const uint32_t>>);
+    assert(rows.size() == n && std::get<0>(rows[3]) == -static_cast<int32_t>(std::get<1>(rows[3])));
+  }
+
+  {
+    // 随机访问迭代器：std::sort按id排序，其它列跟着移动；
+    auto rows = layout.Zip<0, 1, 2>(p);
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+      return std::get<0>(a) < std::get<0>(b);
+    });
+    for (uint32_t i = 0; i < n; ++i) {
+      assert(layout.Pointer<0>(p)[i] == i);
+      assert(layout.Pointer<1>(p)[i] == i * 0.5);
+      assert(layout.Pointer<2>(p)[i] == -static_cast<int32_t>(i));
+    }
+
+    // 其它算法：reverse（swap），find_if，行的拷贝；
+    std::reverse(rows.begin(), rows.end());
+    assert(layout.Pointer<0>(p)[0] == n - 1 && layout.Pointer<2>(p)[0] == -99);
+    auto it = std::find_if(rows.begin(), rows.end(),
+                           [](const auto& r) { return std::get<0>(r) == 10; });
+    assert(it - rows.begin() == 89);
+    ZipRange<uint32_t, double, int32_t>::value_type row = *it;
+    rows[0] = row;
+    assert(layout.Pointer<0>(p)[0] == 10 && layout.Pointer<1>(p)[0] == 5.0);
+    assert(std::get<1>(row) == 5.0);
+  }
+
+  {
+    // ForEach：列指针带__restrict；
+    layout.Zip<0, 1, 2>(p).ForEach([](uint32_t id, double& price, int32_t qty) {
+      price = id + qty;
+    });
+    for (size_t i = 0; i < n; ++i) assert(layout.Pointer<1>(p)[i] == 0);
+  }
+
+  free(p);
+
+  //打印：zip ok
+  std::cout << "zip ok" << std::endl;
+  return 0;
+}
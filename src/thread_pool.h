@@ -0,0 +1,149 @@
+// A fixed-size pool of threads for data-parallel loops.
+//
+//   ThreadPool pool(8);
+//   // fn(w) once on every worker w in [0, pool.size()); the calling thread is
+//   // worker 0. Returns when all of them are done.
+//   pool.Run([&](size_t w) { ... });
+//   // fn(i) for every i in [0, n), handed out dynamically.
+//   pool.ParallelFor(n, [&](size_t i) { ... });
+//
+// `Run()` gives callers a stable worker index, which is what first-touch NUMA
+// placement needs: if worker `w` writes a page first, the page is allocated on
+// `w`'s node. With `pin == true` worker `w` is pinned to CPU `w % ncpu`, so the
+// node doesn't change afterwards either.
+//
+// Only one `Run()`/`ParallelFor()` may be active at a time; calls from inside
+// a running job are not supported.
+
+#ifndef ABSL_CONTAINER_INTERNAL_THREAD_POOL_H_
+#define ABSL_CONTAINER_INTERNAL_THREAD_POOL_H_
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace absl {
+namespace container_internal {
+
+class ThreadPool {
+ public:
+  // `num_threads` includes the calling thread; 0 means one per hardware
+  // thread.
+  explicit ThreadPool(size_t num_threads = 0, bool pin = false) {
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 1;
+    size_ = num_threads;
+    if (pin) Pin(0);
+    for (size_t w = 1; w != num_threads; ++w) {
+      threads_.emplace_back([this, w, pin] {
+        if (pin) Pin(w);
+        WorkerLoop(w);
+      });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& t : threads_) t.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Number of workers, including the calling thread.
+  size_t size() const { return size_; }
+
+  // Calls `fn(w)` on every worker `w` and waits for all of them.
+  template <class Fn>
+  void Run(Fn&& fn) {
+    if (size_ == 1) {
+      fn(size_t{0});
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      job_ = std::ref(fn);
+      pending_ = size_ - 1;
+      ++generation_;
+    }
+    start_cv_.notify_all();
+    fn(size_t{0});
+    std::unique_lock<std::mutex> lock(mu_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+    job_ = nullptr;
+  }
+
+  // Calls `fn(i)` for every `i` in `[0, n)`, `grain` consecutive indices at a
+  // time, and waits for all of them.
+  template <class Fn>
+  void ParallelFor(size_t n, Fn&& fn, size_t grain = 1) {
+    std::atomic<size_t> next{0};
+    Run([&](size_t) {
+      for (;;) {
+        size_t begin = next.fetch_add(grain, std::memory_order_relaxed);
+        if (begin >= n) break;
+        size_t end = begin + grain < n ? begin + grain : n;
+        for (size_t i = begin; i != end; ++i) fn(i);
+      }
+    });
+  }
+
+ private:
+  static void Pin(size_t w) {
+#if defined(__linux__)
+    const size_t ncpu = std::thread::hardware_concurrency();
+    if (ncpu == 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w % ncpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)w;
+#endif
+  }
+
+  void WorkerLoop(size_t w) {
+    uint64_t seen = 0;
+    for (;;) {
+      std::function<void(size_t)> job;
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        job = job_;
+      }
+      job(w);
+      std::lock_guard<std::mutex> lock(mu_);
+      if (--pending_ == 0) done_cv_.notify_one();
+    }
+  }
+
+  size_t size_;
+  std::vector<std::thread> threads_;
+  std::mutex mu_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  std::function<void(size_t)> job_;
+  uint64_t generation_ = 0;
+  size_t pending_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_THREAD_POOL_H_
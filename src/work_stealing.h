@@ -0,0 +1,192 @@
+// Work-stealing deques and a consumer group that combines them with a shared
+// `MpmcQueue`.
+//
+// `WorkStealingDeque<T>` is the Chase-Lev deque, in the form given by Lê, Pop,
+// Cohen and Zappa Nardelli ("Correct and Efficient Work-Stealing for Weak
+// Memory Models", PPoPP 2013). The owner thread pushes and pops at the bottom
+// without any read-modify-write in the common case; other threads steal from
+// the top with one CAS. The buffer grows when full; retired buffers are kept
+// until the deque is destroyed, because a thief may still be reading them.
+//
+// `StealingConsumers<T>` gives each of N consumer threads its own deque. A
+// consumer first pops its own deque, then refills it with a batch from the
+// shared queue, and only then steals from the others. Consumers therefore
+// touch the shared queue once per batch and each other almost never.
+//
+//   MpmcQueue<unsigned char*> queue(1 << 16);
+//   StealingConsumers<unsigned char*> consumers(queue, num_threads);
+//   // In consumer thread `w`:
+//   unsigned char* p;
+//   while (consumers.Next(w, &p)) Process(p);
+
+#ifndef ABSL_CONTAINER_INTERNAL_WORK_STEALING_H_
+#define ABSL_CONTAINER_INTERNAL_WORK_STEALING_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "layout.h"
+#include "mpmc_queue.h"
+
+namespace absl {
+namespace container_internal {
+
+template <class T>
+class WorkStealingDeque {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>, "T must be a handle");
+
+  explicit WorkStealingDeque(size_t capacity = 256) {
+    assert(capacity > 0 && internal_layout::adl_barrier::IsPow2(capacity));
+    buffers_.emplace_back(new Buffer(capacity));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  // Owner only.
+  void Push(T x) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Buffer* a = buffer_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<int64_t>(a->mask)) a = Grow(a, t, b);
+    a->Put(b, x);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only. Takes the most recently pushed element.
+  bool Pop(T* out) {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* a = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    *out = a->Get(b);
+    if (t == b) {
+      // The last element: race against thieves for it.
+      bool won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. Takes the oldest element. May fail spuriously when racing
+  // with another thief or with the owner for the last element.
+  bool Steal(T* out) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return false;
+    Buffer* a = buffer_.load(std::memory_order_acquire);
+    T x = a->Get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    *out = x;
+    return true;
+  }
+
+  // Approximate number of elements.
+  size_t size() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+  }
+
+ private:
+  struct Buffer {
+    explicit Buffer(size_t capacity)
+        : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+    T Get(int64_t i) const {
+      return slots[i & mask].load(std::memory_order_relaxed);
+    }
+    void Put(int64_t i, T x) {
+      slots[i & mask].store(x, std::memory_order_relaxed);
+    }
+
+    const size_t mask;
+    const std::unique_ptr<std::atomic<T>[]> slots;
+  };
+
+  Buffer* Grow(Buffer* a, int64_t t, int64_t b) {
+    Buffer* grown = new Buffer(2 * (a->mask + 1));
+    for (int64_t i = t; i != b; ++i) grown->Put(i, a->Get(i));
+    buffers_.emplace_back(grown);
+    buffer_.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  static constexpr size_t kLine = internal_layout::kCacheLineSize;
+
+  alignas(kLine) std::atomic<int64_t> top_{0};
+  alignas(kLine) std::atomic<int64_t> bottom_{0};
+  std::atomic<Buffer*> buffer_;
+  std::vector<std::unique_ptr<Buffer>> buffers_;  // owner only
+};
+
+template <class T>
+class StealingConsumers {
+ public:
+  static constexpr size_t kMaxBatch = 256;
+
+  // `batch` is the number of elements a consumer takes from `queue` at once.
+  StealingConsumers(MpmcQueue<T>& queue, size_t num_consumers,
+                    size_t batch = 32)
+      : queue_(queue), batch_(batch < kMaxBatch ? batch : kMaxBatch) {
+    assert(num_consumers > 0 && batch > 0);
+    for (size_t i = 0; i != num_consumers; ++i) {
+      deques_.emplace_back(new WorkStealingDeque<T>(2 * kMaxBatch));
+    }
+  }
+
+  size_t num_consumers() const { return deques_.size(); }
+
+  // Called by consumer `w` (one thread per `w`). Returns false if there was no
+  // work anywhere at the time of the call.
+  bool Next(size_t w, T* out) {
+    WorkStealingDeque<T>& own = *deques_[w];
+    if (own.Pop(out)) return true;
+
+    T buf[kMaxBatch];
+    size_t n = queue_.DequeueBatch(buf, batch_);
+    if (n != 0) {
+      // Keep the first one, in reverse so that `Pop()` returns the rest in
+      // queue order and thieves take the newest ones.
+      for (size_t i = n; i-- > 1;) own.Push(buf[i]);
+      *out = buf[0];
+      return true;
+    }
+
+    const size_t num = deques_.size();
+    for (size_t i = 1; i != num; ++i) {
+      if (deques_[(w + i) % num]->Steal(out)) return true;
+    }
+    return false;
+  }
+
+ private:
+  MpmcQueue<T>& queue_;
+  const size_t batch_;
+  std::vector<std::unique_ptr<WorkStealingDeque<T>>> deques_;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+#endif  // ABSL_CONTAINER_INTERNAL_WORK_STEALING_H_
@@ -0,0 +1,215 @@
+// Row-wise iteration over several columns of equal length.
+//
+// This is what `Layout<...>::Zip<N...>(p)` returns. Row `i` is a tuple of
+// references to element `i` of every column, so a structure-of-arrays blob
+// can be walked like an array of structs:
+//
+//   using L = Layout<float, float, float>;
+//   const L layout(n, n, n);
+//   for (auto [x, y, sum] : layout.Zip<0, 1, 2>(p)) sum = x + y;
+//
+//   // Random-access iterators: the rows work with std algorithms, and
+//   // sorting by one column moves the other columns along with it.
+//   auto rows = layout.Zip<0, 1>(p);
+//   std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+//     return std::get<0>(a) < std::get<0>(b);
+//   });
+//
+//   // The same loop with every column pointer `__restrict`-qualified.
+//   layout.Zip<0, 1, 2>(p).ForEach([](float x, float y, float& sum) {
+//     sum = x + y;
+//   });
+//
+// The iterator is a row index plus the column base pointers, so a range-for
+// compiles to the indexed loop one would write by hand. GCC and Clang
+// vectorize it after a runtime check that the columns don't overlap.
+// `ForEach()` passes the columns as `__restrict` parameters, which promises
+// there is no overlap, so the check and the scalar fallback disappear. The
+// columns of one `Layout` block never overlap.
+//
+// A row is a `ZipRef<Ts...>`: a `std::tuple<Ts&...>` whose assignment writes
+// through to the columns, and whose `swap()` swaps the elements, not the
+// references. `std::get`, structured bindings and tuple comparisons work on it.
+// Its `value_type` is `std::tuple<Ts...>`, a copy of one row.
+
+#ifndef ABSL_CONTAINER_INTERNAL_ZIP_RANGE_H_
+#define ABSL_CONTAINER_INTERNAL_ZIP_RANGE_H_
+
+#include <stddef.h>
+
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace absl {
+namespace container_internal {
+
+// One row of a `ZipRange`.
+template <class... Ts>
+class ZipRef : public std::tuple<Ts&...> {
+  using Base = std::tuple<Ts&...>;
+
+ public:
+  using Base::Base;
+  ZipRef(const ZipRef&) = default;
+
+  // Assignment writes through, whether from another row or from a copy.
+  ZipRef& operator=(const ZipRef& other) {
+    Base::operator=(static_cast<const Base&>(other));
+    return *this;
+  }
+  const ZipRef& operator=(const ZipRef& other) const {
+    const_cast<ZipRef&>(*this) = other;
+    return *this;
+  }
+  template <class... Us>
+  const ZipRef& operator=(const std::tuple<Us...>& row) const {
+    const_cast<Base&>(static_cast<const Base&>(*this)) = row;
+    return *this;
+  }
+  template <class... Us>
+  const ZipRef& operator=(std::tuple<Us...>&& row) const {
+    const_cast<Base&>(static_cast<const Base&>(*this)) = std::move(row);
+    return *this;
+  }
+
+  friend void swap(ZipRef a, ZipRef b) {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      using std::swap;
+      (swap(std::get<I>(a), std::get<I>(b)), ...);
+    }(std::index_sequence_for<Ts...>());
+  }
+};
+
+// A random-access range of `ZipRef<Ts...>` over `n` rows of the columns
+// `Ts*...`.
+template <class... Ts>
+class ZipRange {
+ public:
+  using value_type = std::tuple<std::remove_const_t<Ts>...>;
+  using reference = ZipRef<Ts...>;
+
+  class iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = ZipRange::value_type;
+    using reference = ZipRange::reference;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+
+    iterator() = default;
+
+    reference operator*() const { return (*this)[0]; }
+    reference operator[](difference_type k) const {
+      return std::apply(
+          [&](Ts*... cols) { return reference(cols[i_ + k]...); }, cols_);
+    }
+
+    iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++i_;
+      return old;
+    }
+    iterator& operator--() {
+      --i_;
+      return *this;
+    }
+    iterator operator--(int) {
+      iterator old = *this;
+      --i_;
+      return old;
+    }
+    iterator& operator+=(difference_type k) {
+      i_ += k;
+      return *this;
+    }
+    iterator& operator-=(difference_type k) {
+      i_ -= k;
+      return *this;
+    }
+    friend iterator operator+(iterator it, difference_type k) {
+      return it += k;
+    }
+    friend iterator operator+(difference_type k, iterator it) {
+      return it += k;
+    }
+    friend iterator operator-(iterator it, difference_type k) {
+      return it -= k;
+    }
+    friend difference_type operator-(const iterator& a, const iterator& b) {
+      return a.i_ - b.i_;
+    }
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.i_ == b.i_;
+    }
+    friend auto operator<=>(const iterator& a, const iterator& b) {
+      return a.i_ <=> b.i_;
+    }
+
+   private:
+    friend class ZipRange;
+    iterator(const std::tuple<Ts*...>& cols, difference_type i)
+        : cols_(cols), i_(i) {}
+
+    std::tuple<Ts*...> cols_;
+    difference_type i_ = 0;
+  };
+
+  ZipRange(size_t n, Ts*... cols) : cols_(cols...), n_(n) {}
+
+  size_t size() const { return n_; }
+  bool empty() const { return n_ == 0; }
+  iterator begin() const { return iterator(cols_, 0); }
+  iterator end() const {
+    return iterator(cols_, static_cast<ptrdiff_t>(n_));
+  }
+  reference operator[](size_t i) const { return begin()[i]; }
+
+  // Rows `[first, last)`.
+  ZipRange subrange(size_t first, size_t last) const {
+    return std::apply(
+        [&](Ts*... cols) { return ZipRange(last - first, cols + first...); },
+        cols_);
+  }
+
+  // The `I`-th column.
+  template <size_t I>
+  auto* column() const {
+    return std::get<I>(cols_);
+  }
+  const std::tuple<Ts*...>& columns() const { return cols_; }
+
+  // `fn(col0[i], col1[i], ...)` for every row, with the columns passed as
+  // `__restrict` pointers.
+  template <class Fn>
+  void ForEach(Fn fn) const {
+    std::apply([&](Ts*... cols) { Loop(n_, fn, cols...); }, cols_);
+  }
+
+ private:
+  template <class Fn>
+  static void Loop(size_t n, Fn& fn, Ts* __restrict... cols) {
+    for (size_t i = 0; i != n; ++i) fn(cols[i]...);
+  }
+
+  std::tuple<Ts*...> cols_;
+  size_t n_;
+};
+
+}  // namespace container_internal
+}  // namespace absl
+
+template <class... Ts>
+struct std::tuple_size<absl::container_internal::ZipRef<Ts...>>
+    : std::integral_constant<size_t, sizeof...(Ts)> {};
+
+template <size_t I, class... Ts>
+struct std::tuple_element<I, absl::container_internal::ZipRef<Ts...>>
+    : std::tuple_element<I, std::tuple<Ts&...>> {};
+
+#endif  // ABSL_CONTAINER_INTERNAL_ZIP_RANGE_H_